@@ -0,0 +1,469 @@
+/* File: bench.c
+ *
+ * This file contains a small benchmark driver for the gradebook list. Each mode builds a
+ * synthetic class and times one operation on it, printing the results to stdout.
+ *
+ * usage: ./bench walk [students] [lookups]
+ *        ./bench sort [students]
+ *        ./bench insert [students] [rounds]
+ *        ./bench load [students]
+ *        ./bench memory [students] [assignments]
+ *        ./bench grades [students] [assignments]
+ */
+
+#include "linked.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+
+/*! \brief number of assignments given to every synthetic student */
+#define BENCH_ASSIGNMENTS 8
+
+
+/*!
+ * \brief fill a buffer with a random lower case name, starting with a capital
+ *
+ * \param name - buffer to fill, at least 13 characters long
+ */
+void random_name(char *name){
+	int length = 5 + rand() % 8;
+
+	for (int i = 0; i < length; ++i){
+		name[i] = 'a' + rand() % 26;
+	}
+	name[0] -= 'a' - 'A';
+	name[length] = '\0';
+}
+
+
+/*!
+ * \brief seconds of processor time since the given starting clock
+ *
+ * \param start - clock value at the start of the timed section
+ *
+ * \return elapsed seconds
+ */
+double elapsed(clock_t start){
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+
+/*!
+ * \brief wall clock seconds since the given starting time, for timing work spread over threads
+ *
+ * \param start - time at the start of the timed section
+ *
+ * \return elapsed seconds
+ */
+double wall_elapsed(struct timespec *start){
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+/*!
+ * \brief build a class of random students, sorted on family name
+ *
+ * \param students - how many students to create
+ * \param given - output array of given names, MAX_STRING_LENGTH apart
+ * \param family - output array of family names, MAX_STRING_LENGTH apart
+ *
+ * \return pointer to the head node
+ */
+struct node *random_class(long int students, char *given, char *family){
+	struct assignment assignments[BENCH_ASSIGNMENTS];
+	char names[BENCH_ASSIGNMENTS][MAX_STRING_LENGTH];
+	struct node *head = NULL;
+
+	for (int j = 0; j < BENCH_ASSIGNMENTS; ++j){
+		snprintf(names[j], MAX_STRING_LENGTH, "Assignment_%d", j + 1);
+		assignments[j].name = names[j];
+	}
+
+	for (long int i = 0; i < students; ++i){
+		random_name(given + i * MAX_STRING_LENGTH);
+		random_name(family + i * MAX_STRING_LENGTH);
+		for (int j = 0; j < BENCH_ASSIGNMENTS; ++j){
+			assignments[j].value = rand() % 10001 / 100.0;
+		}
+		head = insert(head, given + i * MAX_STRING_LENGTH, family + i * MAX_STRING_LENGTH,
+		              assignments, BENCH_ASSIGNMENTS, FAMILY, ASCEND);
+	}
+
+	return head;
+}
+
+
+/*!
+ * \brief time walks down the list: each lookup walks from the head to a random student
+ *
+ * \param students - size of the class
+ * \param lookups - number of walks to time
+ */
+void bench_walk(long int students, long int lookups){
+	char *given = (char *)malloc(students * MAX_STRING_LENGTH);
+	char *family = (char *)malloc(students * MAX_STRING_LENGTH);
+	struct node *head = random_class(students, given, family);
+	long int hops = 0;
+	clock_t start = clock();
+
+	for (long int q = 0; q < lookups; ++q){
+		long int i = rand() % students;
+		struct node *found = location(head, given + i * MAX_STRING_LENGTH, family + i * MAX_STRING_LENGTH);
+		hops += (found != NULL);
+	}
+
+	printf("walk: %ld students, %ld lookups, %.3f s\n", students, hops, elapsed(start));
+
+	delete_list(head);
+	free(given);
+	free(family);
+}
+
+
+/*!
+ * \brief build a list of random students without sorting it
+ *
+ * \param students - how many students to create
+ *
+ * \return pointer to the head node
+ */
+struct node *random_unsorted(long int students){
+	struct node *head = NULL;
+	struct node *tmp;
+	char given[MAX_STRING_LENGTH];
+	char family[MAX_STRING_LENGTH];
+
+	for (long int i = 0; i < students; ++i){
+		random_name(given);
+		random_name(family);
+		tmp = new_node(given, family, NULL, 0, GIVEN, ASCEND);
+		tmp->previous = head;
+		if (head != NULL){
+			head->next = tmp;
+		}
+		head = tmp;
+	}
+
+	return head;
+}
+
+
+/*!
+ * \brief plain comparison merge sort of nodes on family name, used as the baseline
+ *
+ * \param nodes - array to sort
+ * \param scratch - scratch array of the same length
+ * \param length - how many nodes there are
+ */
+void merge_sort(struct node **nodes, struct node **scratch, long int length){
+	long int half = length / 2;
+	long int i = 0, j = half, k = 0;
+
+	if (length < 2) return;
+
+	merge_sort(nodes, scratch, half);
+	merge_sort(nodes + half, scratch, length - half);
+
+	while (i < half && j < length){
+		scratch[k++] = (strcmp(nodes[j]->last_name, nodes[i]->last_name) < 0) ? nodes[j++] : nodes[i++];
+	}
+	while (i < half) scratch[k++] = nodes[i++];
+	while (j < length) scratch[k++] = nodes[j++];
+
+	memcpy(nodes, scratch, length * sizeof(struct node *));
+}
+
+
+/*!
+ * \brief time re-sorting a class on family name, radix sort against a comparison merge sort
+ *
+ * \param students - size of the class
+ */
+void bench_sort(long int students){
+	struct node *head = random_unsorted(students);
+	struct node **nodes = (struct node **)malloc(students * sizeof(struct node *));
+	struct node **scratch = (struct node **)malloc(students * sizeof(struct node *));
+	struct node *cursor;
+	clock_t start;
+
+	for (int run = 0; run < 2; ++run){
+		/* shuffle into a random list order, so neither sort gets walks in allocation order */
+		cursor = head_pointer(head);
+		for (long int i = 0; i < students; ++i, cursor = cursor->previous){
+			nodes[i] = cursor;
+		}
+		for (long int i = students - 1; i > 0; --i){
+			long int j = rand() % (i + 1);
+			cursor = nodes[i];
+			nodes[i] = nodes[j];
+			nodes[j] = cursor;
+		}
+		head = relink(nodes, students, GIVEN, ASCEND);
+
+		start = clock();
+		if (run == 0){
+			cursor = head;
+			for (long int i = 0; i < students; ++i, cursor = cursor->previous){
+				nodes[i] = cursor;
+			}
+			merge_sort(nodes, scratch, students);
+			head = relink(nodes, students, FAMILY, ASCEND);
+			printf("sort: %ld students, merge sort %.3f s\n", students, elapsed(start));
+		}else{
+			head = sort_list(head, FAMILY, ASCEND);
+			printf("sort: %ld students, radix sort %.3f s\n", students, elapsed(start));
+		}
+	}
+
+	delete_list(head);
+	free(nodes);
+	free(scratch);
+}
+
+
+/*!
+ * \brief time sorted inserts into a growing list, for each sort key and order
+ *
+ * \param students - number of students to insert
+ * \param rounds - how many times to build the list
+ */
+void bench_insert(long int students, long int rounds){
+	char *given = (char *)malloc(students * MAX_STRING_LENGTH);
+	char *family = (char *)malloc(students * MAX_STRING_LENGTH);
+	int keys[] = {GIVEN, FAMILY};
+	int orders[] = {ASCEND, DESCEND};
+	struct node *head;
+	clock_t start;
+
+	for (long int i = 0; i < students; ++i){
+		random_name(given + i * MAX_STRING_LENGTH);
+		random_name(family + i * MAX_STRING_LENGTH);
+	}
+
+	for (int k = 0; k < 2; ++k){
+		for (int o = 0; o < 2; ++o){
+			start = clock();
+			for (long int r = 0; r < rounds; ++r){
+				head = NULL;
+				for (long int i = 0; i < students; ++i){
+					head = insert(head, given + i * MAX_STRING_LENGTH, family + i * MAX_STRING_LENGTH,
+					              NULL, 0, keys[k], orders[o]);
+				}
+				delete_list(head);
+			}
+			printf("insert: %ld students x %ld, key %d order %2d, %.3f s\n", students, rounds, keys[k],
+			       orders[o], elapsed(start));
+		}
+	}
+
+	free(given);
+	free(family);
+}
+
+
+/*!
+ * \brief write a random gradebook to a new temporary file
+ *
+ * \param path - template for mkstemp, filled in with the name of the file
+ * \param students - number of records to write
+ * \param assignments - number of assignments per record
+ *
+ * \return 0 on success, -1 if the file could not be created
+ */
+int random_gradebook(char *path, long int students, long int assignments){
+	char name[MAX_STRING_LENGTH];
+	FILE *file;
+	int fd = mkstemp(path);
+
+	if (fd < 0){
+		perror("mkstemp");
+		return -1;
+	}
+
+	file = fdopen(fd, "w");
+	fprintf(file, "%ld,%ld\n", students, assignments);
+	for (long int i = 0; i < students; ++i){
+		random_name(name);
+		fprintf(file, "%s,", name);
+		random_name(name);
+		fprintf(file, "%s", name);
+		for (long int j = 0; j < assignments; ++j){
+			fprintf(file, ",Assignment_%ld,%.2f", j + 1, rand() % 10001 / 100.0);
+		}
+		fprintf(file, "\n");
+	}
+	fclose(file);
+
+	return 0;
+}
+
+
+/*!
+ * \brief time loading a gradebook file, with list_from_file against the pipelined list_from_fd
+ *
+ * \param students - number of records in the file
+ */
+void bench_load(long int students){
+	char path[] = "/tmp/benchXXXXXX";
+	struct timespec start;
+	struct node *head;
+	FILE *file;
+	int fd;
+	int error;
+
+	if (random_gradebook(path, students, BENCH_ASSIGNMENTS) != 0) return;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	file = fopen(path, "r");
+	head = list_from_file(NULL, file, FAMILY, ASCEND);
+	fclose(file);
+	printf("load: %ld students, list_from_file %.3f s (%d loaded)\n", students, wall_elapsed(&start),
+	       list_length(head));
+	delete_list(head);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	fd = open(path, O_RDONLY);
+	head = list_from_fd(NULL, fd, FAMILY, ASCEND, &error);
+	close(fd);
+	printf("load: %ld students, list_from_fd   %.3f s (%d loaded, error %d)\n", students,
+	       wall_elapsed(&start), list_length(head), error);
+	delete_list(head);
+
+	unlink(path);
+}
+
+
+/*!
+ * \brief load a synthetic gradebook of the given shape and report where the memory went, along
+ * with the peak resident set size of the process. Run it once per process, the peak never drops.
+ *
+ * \param students - number of records in the file
+ * \param assignments - number of assignments per record
+ */
+void bench_memory(long int students, long int assignments){
+	char path[] = "/tmp/benchXXXXXX";
+	struct memory_usage usage;
+	struct rusage resources;
+	struct node *head;
+	FILE *file;
+
+	if (random_gradebook(path, students, assignments) != 0) return;
+
+	file = fopen(path, "r");
+	head = list_from_file(NULL, file, FAMILY, ASCEND);
+	fclose(file);
+	unlink(path);
+
+	usage = list_memory_usage(head);
+	getrusage(RUSAGE_SELF, &resources);
+
+	printf("memory: %ld students x %ld assignments\n", students, assignments);
+	print_memory_usage(stdout, &usage);
+	printf("peak rss:           %10ld kB\n", resources.ru_maxrss);
+
+	delete_list(head);
+}
+
+
+/*!
+ * \brief time weighted final grades, walking the list with a name lookup per score against the
+ * packed score table
+ *
+ * \param students - number of students
+ * \param assignments - number of assignments, all weighted
+ */
+void bench_grades(long int students, long int assignments){
+	char path[] = "/tmp/benchXXXXXX";
+	char **names = (char **)malloc(assignments * sizeof(char *));
+	double *weights = (double *)malloc(assignments * sizeof(double));
+	double *walked = (double *)malloc(students * sizeof(double));
+	double *packed = (double *)malloc(students * sizeof(double));
+	struct score_table *t;
+	struct timespec start;
+	struct node *head;
+	struct node *cursor;
+	double worst = 0.0;
+	long int a;
+	int fd;
+	int error;
+
+	if (random_gradebook(path, students, assignments) != 0) return;
+	fd = open(path, O_RDONLY);
+	head = list_from_fd(NULL, fd, FAMILY, ASCEND, &error);
+	close(fd);
+	unlink(path);
+
+	for (long int j = 0; j < assignments; ++j){
+		names[j] = (char *)malloc(MAX_STRING_LENGTH);
+		snprintf(names[j], MAX_STRING_LENGTH, "Assignment_%ld", j + 1);
+		weights[j] = 1.0 / assignments;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	cursor = head_pointer(head);
+	for (long int i = 0; i < students; ++i, cursor = cursor->previous){
+		walked[i] = 0.0;
+		for (long int j = 0; j < assignments; ++j){
+			a = assignment_index(cursor, names[j]);
+			if (a >= 0) walked[i] += weights[j] * cursor->assignments[a].value;
+		}
+	}
+	printf("grades: %ld students x %ld, list walk      %.4f s\n", students, assignments, wall_elapsed(&start));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	t = score_table_from_list(head);
+	printf("grades: %ld students x %ld, table build    %.4f s\n", students, assignments, wall_elapsed(&start));
+
+	/* the table keeps its own copy of the names, so the list is no longer needed */
+	delete_list(head);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	final_grades(t, names, weights, assignments, packed);
+	printf("grades: %ld students x %ld, packed columns %.4f s\n", students, assignments, wall_elapsed(&start));
+
+	for (long int i = 0; i < students; ++i){
+		worst = max(worst, fabs(walked[i] - packed[i]));
+	}
+	printf("grades: largest difference %g\n", worst);
+
+	for (long int j = 0; j < assignments; ++j){
+		free(names[j]);
+	}
+	free(names);
+	free(weights);
+	free(walked);
+	free(packed);
+	score_table_free(t);
+}
+
+
+int main(int argc, char **argv){
+	srand(151);
+
+	if (argc > 1 && strcmp(argv[1], "walk") == 0){
+		bench_walk((argc > 2) ? atol(argv[2]) : 20000, (argc > 3) ? atol(argv[3]) : 20000);
+	}else if (argc > 1 && strcmp(argv[1], "sort") == 0){
+		bench_sort((argc > 2) ? atol(argv[2]) : 1000000);
+	}else if (argc > 1 && strcmp(argv[1], "insert") == 0){
+		bench_insert((argc > 2) ? atol(argv[2]) : 5000, (argc > 3) ? atol(argv[3]) : 20);
+	}else if (argc > 1 && strcmp(argv[1], "load") == 0){
+		bench_load((argc > 2) ? atol(argv[2]) : 1000000);
+	}else if (argc > 1 && strcmp(argv[1], "memory") == 0){
+		bench_memory((argc > 2) ? atol(argv[2]) : 100000, (argc > 3) ? atol(argv[3]) : BENCH_ASSIGNMENTS);
+	}else if (argc > 1 && strcmp(argv[1], "grades") == 0){
+		bench_grades((argc > 2) ? atol(argv[2]) : 100000, (argc > 3) ? atol(argv[3]) : 50);
+	}else{
+		fprintf(stderr, "usage: %s walk [students] [lookups] | sort [students] | insert [students] [rounds]"
+		        " | load [students] | memory [students] [assignments] | grades [students] [assignments]\n",
+		        argv[0]);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,3 @@
+#!/bin/bash
+gcc bench.c -std=c99 -O2 -pthread -o bench -lm
+./bench "$@"
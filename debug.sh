@@ -1,5 +1,5 @@
 #!/bin/bash
-gcc main.c -std=c99 -g -o debug
+gcc main.c -std=c99 -g -pthread -o debug
 gdb ./debug
 #another git test
 #this is a git test
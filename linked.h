@@ -11,11 +11,22 @@
  * descriptive statistics upon such records
  */
 
+/* fork, pipe and friends are POSIX, so ask for them before any system header is seen */
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <float.h>
 #include <string.h>
 #include <math.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#include <errno.h>
 
 #ifndef DMCGRATH_LINKED_LIST_H
 #define DMCGRATH_LINKED_LIST_H
@@ -23,6 +34,42 @@
 /*! \brief the maximum value for any string in the list */
 #define MAX_STRING_LENGTH 100
 
+#ifndef INLINE_NAME_LENGTH
+/*! \brief names up to this long (terminator included) are stored inside the node itself */
+#define INLINE_NAME_LENGTH 16
+#endif
+
+/*! \brief number of leading name bytes packed into each node's integer sort prefix */
+#define KEY_PREFIX_LENGTH 8
+
+/*! \brief parts of a name sort smaller than this are finished with an insertion sort */
+#define NAME_SORT_CUTOFF 16
+
+#define SKETCH_LOW 0                       /*!< \brief lowest score a sketch bins exactly */
+#define SKETCH_HIGH 100                    /*!< \brief highest score a sketch bins exactly */
+#define SKETCH_RESOLUTION 100              /*!< \brief sketch bins per point, i.e. two decimals */
+/*! \brief number of bins in a column sketch */
+#define SKETCH_BINS ((SKETCH_HIGH - SKETCH_LOW) * SKETCH_RESOLUTION + 1)
+
+/*! \brief bytes of header glibc malloc keeps ahead of each chunk */
+#define MALLOC_HEADER 8
+/*! \brief alignment of glibc malloc chunks */
+#define MALLOC_ALIGNMENT 16
+/*! \brief smallest chunk glibc malloc hands out */
+#define MALLOC_MINIMUM_CHUNK 32
+
+/*! \brief size of each of the buffers list_from_fd reads into */
+#define LOADER_BUFFER_SIZE (1 << 20)
+/*! \brief number of buffers list_from_fd cycles through (2 is double buffering) */
+#define LOADER_BUFFERS 2
+
+/*! \brief packed score code marking a missing grade */
+#define PACKED_MISSING 0xFFFF
+/*! \brief scores packed_axpy handles per group, enough to fill the vector registers */
+#define PACKED_LANES 8
+/*! \brief rows of a score table final_grades totals at a time */
+#define FINAL_GRADE_BLOCK 2048
+
 /*!
  * \brief Holds the values which comprise the elements of an assignment pair.
  */
@@ -54,6 +101,20 @@ struct node{
 	int sort_key;
 	/*! \brief store the sort order in every node */
 	int sort_order;
+
+	/*! \brief room in the assignments array, wherever it lives (drop_assignment leaves spare room) */
+	int assignment_capacity;
+	/*! \brief assignment slots allocated along with the node, kept even once the array moves out */
+	int inline_assignments;
+
+	/*! \brief leading bytes of both names packed big endian, indexed by sort key, so that most
+	 * comparisons are a single integer compare */
+	uint64_t key_prefix[2];
+
+	/*! \brief storage for short first and last names, indexed by sort key */
+	char inline_names[2][INLINE_NAME_LENGTH];
+
+	/* the assignment array follows the node in the same allocation, see new_node */
 };
 
 /*!
@@ -66,10 +127,215 @@ struct stats{
 
 };
 
+/*!
+ * \brief heap used by a list, as reported by list_memory_usage. Byte counts are what was asked of
+ * malloc; the allocator's own headers and rounding are estimated separately in overhead_bytes.
+ */
+struct memory_usage{
+	long int nodes;                        /*!< \brief number of nodes in the list */
+	size_t node_bytes;                     /*!< \brief the nodes themselves, with inline names */
+	size_t name_bytes;                     /*!< \brief names too long to live in their node */
+	size_t assignment_array_bytes;         /*!< \brief assignment slots, in the node or moved out */
+	size_t assignment_name_bytes;          /*!< \brief assignment name strings */
+	long int allocations;                  /*!< \brief number of separate heap allocations */
+	size_t overhead_bytes;                 /*!< \brief estimated allocator headers and padding */
+	size_t total_bytes;                    /*!< \brief sum of all of the above */
+};
+
+/*!
+ * \brief constant size summary of one assignment column, built while streaming a file. Sums give
+ * the mean and standard deviation, and a histogram on the SKETCH_RESOLUTION grid gives quantiles
+ * (exactly, for scores on the grid). Two sketches of the same column can be merged exactly.
+ */
+struct column_sketch{
+	char name[MAX_STRING_LENGTH];          /*!< \brief name of the assignment */
+	long int count;                        /*!< \brief number of scores seen */
+	long double sum;                       /*!< \brief sum of the scores */
+	long double sum_squares;               /*!< \brief sum of the squared scores */
+	double low;                            /*!< \brief lowest score seen */
+	double high;                           /*!< \brief highest score seen */
+	long int bins[SKETCH_BINS];            /*!< \brief count of scores in each bin */
+};
+
+/*!
+ * \brief one assignment of a score table, stored as 16 bit fixed point codes: a score is
+ * code / scale, where scale is 100, 10 or 1 codes per point.
+ */
+struct packed_column{
+	char *name;                            /*!< \brief name of the assignment */
+	double scale;                          /*!< \brief codes per point in this column */
+	uint16_t *scores;                      /*!< \brief one code per student, or PACKED_MISSING */
+};
+
+/*!
+ * \brief compact, column major store of the names and scores of a class. It owns everything it
+ * points to, so the list it was built from can be freed.
+ */
+struct score_table{
+	long int rows;                         /*!< \brief number of students */
+	long int num_columns;                  /*!< \brief number of assignments */
+	struct packed_column *columns;         /*!< \brief one packed column per assignment */
+	char **first_names;                    /*!< \brief given name of each row, in list order */
+	char **last_names;                     /*!< \brief family name of each row, in list order */
+	char *name_store;                      /*!< \brief one block holding all the row names */
+};
+
+/*!
+ * \brief ordered index over a list: its nodes in ascending order of the sort name, so students
+ * can be found by binary search
+ */
+struct list_index{
+	struct node **nodes;                   /*!< \brief the nodes, ascending on the sort name */
+	long int length;                       /*!< \brief number of nodes */
+	int sort_key;                          /*!< \brief sort key of the indexed list */
+	int sort_order;                        /*!< \brief sort order of the indexed list */
+};
+
+/*!
+ * \brief cursor over a range of a list_index, handing out nodes without copying them
+ */
+struct list_cursor{
+	struct list_index *index;              /*!< \brief the index being walked */
+	long int start;                        /*!< \brief first position in the range */
+	long int end;                          /*!< \brief one past the last position in the range */
+	long int position;                     /*!< \brief the next position to hand out */
+};
+
+/*!
+ * \brief state shared between list_from_fd and its reader thread. Buffers are filled by the reader
+ * and parsed by the caller in turn; \a ready says who owns each one.
+ */
+struct loader{
+	int fd;                                /*!< \brief the file being read */
+	char *buffers[LOADER_BUFFERS];         /*!< \brief the read buffers */
+	ssize_t filled[LOADER_BUFFERS];        /*!< \brief bytes in each buffer, 0 at end, -1 on error */
+	int ready[LOADER_BUFFERS];             /*!< \brief 1 while a buffer waits for the parser */
+	int error;                             /*!< \brief errno of a failed read */
+	int stop;                              /*!< \brief set when the parser wants no more data */
+	pthread_mutex_t lock;                  /*!< \brief guards ready and stop */
+	pthread_cond_t changed;                /*!< \brief signalled whenever ready or stop change */
+};
+
+/*!
+ * \brief parser state for list_from_fd
+ */
+struct loader_parse{
+	struct node *records;                  /*!< \brief head of the chain of new records */
+	struct node *tail;                     /*!< \brief tail of the chain of new records */
+	long int number_pairs;                 /*!< \brief assignments per record, -1 before the header */
+	struct assignment *assignments;        /*!< \brief scratch array for one record */
+	char *line;                            /*!< \brief a line split across two buffers */
+	long int line_length;                  /*!< \brief characters in \a line */
+	long int line_capacity;                /*!< \brief size of \a line */
+	int sort_key;                          /*!< \brief sort key for the new nodes */
+	int sort_order;                        /*!< \brief sort order for the new nodes */
+};
+
+/*!
+ * \brief entry of the heap merge_lists keeps over the heads of the lists it merges
+ */
+struct merge_source{
+	struct node *node;                     /*!< \brief first node not yet merged from this list */
+	int list;                              /*!< \brief which list it is, to keep the merge stable */
+};
+
+/*!
+ * \brief a student and the score they are ranked on
+ */
+struct score_entry{
+	double score;                          /*!< \brief the score, -HUGE_VAL if missing */
+	struct node *node;                     /*!< \brief the student */
+};
+
+/*!
+ * \brief students in ascending order of a score, kept current through indexed_insert,
+ * indexed_delete_nth and score_index_update
+ */
+struct score_index{
+	struct score_entry *entries;           /*!< \brief the students, lowest score first */
+	long int length;                       /*!< \brief number of students */
+	long int capacity;                     /*!< \brief room in entries */
+	char *assignment;                      /*!< \brief assignment ranked on, NULL for the mean */
+};
+
+/*!
+ * \brief hash table of the students of a list, keyed on both names, with linear probing. It points
+ * into the list, and is kept current through upsert and upserted_delete_nth; any other change to
+ * the list leaves it stale, to be rebuilt with student_table_build.
+ */
+struct student_table{
+	struct node **slots;                   /*!< \brief the students, NULL for an empty slot */
+	long int capacity;                     /*!< \brief number of slots, a power of 2 */
+	long int count;                        /*!< \brief number of students */
+};
+
+/*!
+ * \brief element of the array sorted by bulk_sort_list. Copying the key prefix next to the node
+ * pointer keeps the first passes of the sort within one contiguous array.
+ */
+struct sort_entry{
+	uint64_t prefix;                       /*!< \brief key prefix of the node being sorted */
+	struct node *node;                     /*!< \brief the node being sorted */
+};
+
+/*!
+ * \brief one line of a delta file, a single score change
+ */
+struct delta{
+	/*! \brief given and family name, indexed by sort key like the names[] arrays elsewhere */
+	char names[2][MAX_STRING_LENGTH];
+	/*! \brief name of the assignment to change */
+	char assignment[MAX_STRING_LENGTH];
+	/*! \brief the new score */
+	double value;
+	/*! \brief which of the names the deltas are sorted on */
+	int sort_key;
+	/*! \brief line number in the file, so repeated changes apply in file order */
+	long int line;
+};
+
+/*!
+ * \brief reference counted holder for a student record shared between gradebook versions
+ */
+struct version_record{
+	struct node *student;                  /*!< \brief detached record, next/previous unused */
+	int references;                        /*!< \brief number of tree nodes sharing the record */
+};
+
+/*!
+ * \brief node of a persistent balanced (AVL) tree, ordered on family then given name. Nodes are
+ * shared between versions, and only copied when a version writes through them.
+ */
+struct version_node{
+	/*! \brief subtree holding the names ordered before this one */
+	struct version_node *left;
+	/*! \brief subtree holding the names ordered after this one */
+	struct version_node *right;
+	/*! \brief the (possibly shared) student stored at this node */
+	struct version_record *record;
+	/*! \brief height of the subtree rooted here, used for balancing */
+	int height;
+	/*! \brief number of parents (or versions) pointing at this node */
+	int references;
+};
+
+/*!
+ * \brief a single version, or snapshot, of a gradebook
+ */
+struct version{
+	struct version_node *root;             /*!< \brief root of the shared tree */
+	long int length;                       /*!< \brief number of students in this version */
+};
+
 #define FAMILY 1                           /*!< \brief constant to indicate family name as sort key */
 #define GIVEN 0                            /*!< \brief constant to indicate given name as sort key */
+#define SCORE 2                            /*!< \brief sort key of a list sorted on the mean score */
+#define ASSIGNMENT_SCORE 3                 /*!< \brief sort key of a list sorted on one assignment's score;
+                                                       only sort_list_by_score sets it, other sorts reject it */
 #define ASCEND 1                           /*!< \brief constant to indicate ascending sort order */
 #define DESCEND (-1)                       /*!< \brief constant to indicate descending sort order */
+#define UPSERT_MERGE 0                     /*!< \brief upsert adds to the scores a student has */
+#define UPSERT_REPLACE 1                   /*!< \brief upsert replaces the scores a student has */
 
 #ifndef max
 #define max(a,b) (((a) > (b)) ? (a) : (b)) /*!< \brief macro definition of type independent max */
@@ -91,6 +357,7 @@ void print_list(struct node *head);
 int list_length(struct node *head);
 struct node *delete_list(struct node *head);
 struct node *list_from_file(struct node *head, FILE *stream, int sort_key, int sort_order);
+struct node *chain_from_file(struct node *head, FILE *stream, int sort_key, int sort_order);
 struct assignment *assignment_list(struct node *head, char *given, char *family, long int *length);
 struct stats student_statistics(struct node *head, char *given, char *family);
 struct stats class_statistics(struct node *head, char *assignment);
@@ -102,15 +369,173 @@ int compare(const void *s, const void *t);
 double median(double *list, long int length);
 struct node *head_pointer(struct node *head);
 struct node *tail_pointer(struct node *head);
+struct node *insert_node(struct node *head, struct node *tmp, int name_order, int sort_order);
 struct node *location(struct node* head, char *given, char *family);
-void place(char *given, char *family, struct node *cursor, struct node *tmp);
-int location_compare(char *name, char *name2, int direction);
-int place_compare(char *name, char *name2, int direction);
+uint64_t key_prefix(char *name);
+int key_compare(uint64_t prefix, char *name, uint64_t prefix2, char *name2);
+
+/* search and insertion kernels, one per sort key and order (see LIST_KERNELS) */
+struct node *location_given_ascend(struct node *head, uint64_t prefix, char *name);
+struct node *location_given_descend(struct node *head, uint64_t prefix, char *name);
+struct node *location_family_ascend(struct node *head, uint64_t prefix, char *name);
+struct node *location_family_descend(struct node *head, uint64_t prefix, char *name);
+void insert_given_ascend(struct node *head, struct node *tmp);
+void insert_given_descend(struct node *head, struct node *tmp);
+void insert_family_ascend(struct node *head, struct node *tmp);
+void insert_family_descend(struct node *head, struct node *tmp);
+extern struct node *(*const location_kernels[2][2])(struct node *, uint64_t, char *);
+extern void (*const insert_kernels[2][2])(struct node *, struct node *);
 struct node* delete_nth(struct node *head, int location);
 
-void populate_node(struct node *n, char *first_name, char *last_name,
-                   struct assignment *assignments, long int num_assignments,
-                   int sort_key, int sort_order);
+int populate_node(struct node *n, char *first_name, char *last_name,
+                  struct assignment *assignments, long int num_assignments,
+                  int sort_key, int sort_order);
+int node_fill(struct node *n, char *first_name, char *last_name, struct assignment *assignments,
+              long int num_assignments, int sort_key, int sort_order, struct assignment *storage);
+void node_clear(struct node *n, int sort_key, int sort_order);
+void free_node(struct node *n);
+struct node *new_node(char *first_name, char *last_name, struct assignment *assignments,
+                      long int num_assignments, int sort_key, int sort_order);
+int node_assignments_inline(struct node *n);
+
+/* bulk name sorting */
+struct node *bulk_sort_list(struct node *head, int sort_key, int sort_order);
+void name_sort(struct sort_entry *entries, long int length, int sort_key, int depth);
+int name_char(struct sort_entry *e, int sort_key, int depth);
+struct node *relink(struct node **nodes, long int length, int sort_key, int sort_order);
+
+/* pipelined loading */
+struct node *list_from_fd(struct node *head, int fd, int sort_key, int sort_order, int *error);
+void *loader_read(void *arg);
+int loader_carry(struct loader_parse *parse, char *text, long int length);
+int loader_parse_line(struct loader_parse *parse, char *line);
+
+/* streaming statistics */
+struct column_sketch *stream_statistics(FILE *stream, long int *num_columns);
+void sketch_init(struct column_sketch *sketch, char *name);
+void sketch_add(struct column_sketch *sketch, double value);
+struct stats sketch_stats(struct column_sketch *sketch);
+double sketch_quantile(struct column_sketch *sketch, double p);
+double sketch_rank(struct column_sketch *sketch, long int rank);
+
+/* sharded statistics */
+void sketch_write(FILE *stream, struct column_sketch *columns, long int num_columns);
+struct column_sketch *sketch_read(FILE *stream, long int *num_columns);
+void sketch_merge(struct column_sketch *into, struct column_sketch *from);
+struct column_sketch *sketch_merge_columns(struct column_sketch *columns, long int *num_columns,
+                                           struct column_sketch *more, long int num_more);
+struct column_sketch *sharded_statistics(char **files, int num_files, long int *num_columns);
+struct stats sharded_class_statistics(char **files, int num_files, char *assignment);
+
+/* packed score tables */
+struct score_table *score_table_from_list(struct node *head);
+void score_table_free(struct score_table *t);
+long int packed_column_index(struct score_table *t, char *assignment);
+long int packed_find(struct node *n, char *assignment, long int guess);
+uint16_t packed_encode(double value, double scale);
+double packed_mean(uint16_t *scores, long int length, double scale);
+double packed_stddev(uint16_t *scores, long int length, double scale);
+double packed_median(uint16_t *scores, long int length, double scale);
+struct stats packed_class_statistics(struct score_table *t, char *assignment);
+
+/* weighted final grades */
+int final_grades(struct score_table *t, char **assignments, double *weights, long int num_weights,
+                 double *grades);
+void packed_axpy(double * restrict totals, const uint16_t * restrict scores, long int length, double weight);
+double *list_final_grades(struct node *head, char **assignments, double *weights, long int num_weights);
+
+/* ordered range and prefix queries */
+struct list_index *list_index_build(struct node *head);
+void list_index_free(struct list_index *index);
+long int index_seek(struct list_index *index, char *name, size_t prefix_length);
+struct list_cursor cursor_range(struct list_index *index, char *low, char *high);
+struct list_cursor cursor_prefix(struct list_index *index, char *prefix);
+struct node *cursor_next(struct list_cursor *cursor);
+
+/* memory accounting */
+struct memory_usage list_memory_usage(struct node *head);
+void memory_account(struct memory_usage *usage, size_t bytes);
+size_t malloc_chunk_size(size_t bytes);
+void print_memory_usage(FILE *stream, struct memory_usage *usage);
+
+/* merging sorted lists */
+struct node *merge_lists(struct node **lists, int num_lists, int sort_key, int sort_order, int combine);
+struct node *merge_files(FILE **streams, int num_streams, int sort_key, int sort_order, int combine);
+int list_in_order(struct node *head, int sort_key, int sort_order);
+void merge_sift(struct merge_source *heap, int size, int i, int sort_key, int sort_order);
+int merge_compare(struct merge_source *a, struct merge_source *b, int sort_key, int sort_order);
+void combine_students(struct node *keep, struct node *extra);
+
+/* score ordering */
+struct node *sort_list_by_score(struct node *head, char *assignment, int sort_order);
+struct node *insert_by_score(struct node *head, struct node *tmp);
+double node_score(struct node *n, char *assignment);
+void score_merge_sort(struct score_entry *entries, struct score_entry *scratch, long int length);
+struct score_index *score_index_build(struct node *head, char *assignment);
+void score_index_free(struct score_index *index);
+long int score_index_seek(struct score_index *index, double score, int after);
+int score_index_add(struct score_index *index, struct node *n);
+int score_index_remove(struct score_index *index, struct node *n);
+int score_index_update(struct score_index *index, struct node *n);
+struct node *score_index_nth(struct score_index *index, long int rank, int sort_order);
+struct node *indexed_insert(struct node *head, struct score_index *index, char *given, char *family,
+                            struct assignment *assignments, long int num_assignments, int name_order,
+                            int sort_order);
+struct node *indexed_delete_nth(struct node *head, struct score_index *index, int location);
+
+/* deduplicating upserts */
+struct node *upsert(struct node *head, struct student_table *t, char *given, char *family,
+                    struct assignment *assignments, long int num_assignments, int name_order,
+                    int sort_order, int mode);
+struct node *upsert_from_file(struct node *head, FILE *stream, int sort_key, int sort_order, int mode);
+struct node *upserted_delete_nth(struct node *head, struct student_table *t, int location);
+struct node *replace_student(struct node *old, struct node *replacement);
+void merge_scores(struct node *n, struct assignment *assignments, long int num_assignments);
+struct student_table *student_table_new(long int expected);
+struct student_table *student_table_build(struct node *head);
+void student_table_free(struct student_table *t);
+uint64_t student_hash(char *given, char *family);
+long int student_table_slot(struct student_table *t, char *given, char *family);
+struct node *student_table_find(struct student_table *t, char *given, char *family);
+int student_table_add(struct student_table *t, struct node *n);
+int student_table_remove(struct student_table *t, struct node *n);
+
+/* in place updates */
+struct node *find_student(struct node *head, char *given, char *family);
+int set_score(struct node *head, char *given, char *family, char *assignment, double value);
+long int add_assignment(struct node *head, char *assignment, double value);
+long int drop_assignment(struct node *head, char *assignment);
+long int apply_delta_file(struct node *head, FILE *stream, long int *error_line);
+long int assignment_index(struct node *n, char *assignment);
+int node_add_assignment(struct node *n, char *assignment, double value);
+int delta_compare(const void *s, const void *t);
+long int delta_seek(struct delta *deltas, long int length, char *name);
+
+/* persistent (copy on write) gradebook versions */
+struct version *version_from_list(struct node *head);
+struct version *version_snapshot(struct version *v);
+struct version *version_insert(struct version *v, char *given, char *family,
+                               struct assignment *assignments, long int num_assignments);
+int version_set_score(struct version *v, char *given, char *family, char *assignment, double value);
+struct node *version_find(struct version *v, char *given, char *family);
+struct node *list_from_version(struct version *v, int sort_key, int sort_order);
+void version_free(struct version *v);
+
+/* version helpers */
+int version_compare(char *given, char *family, struct node *student);
+int version_record_compare(const void *s, const void *t);
+int version_height(struct version_node *n);
+struct version_record *version_record_new(struct node *student);
+struct version_node *version_build(struct version_record **records, long int length);
+struct version_node *version_edit(struct version_node *n);
+struct version_record *version_record_edit(struct version_record *r);
+struct version_node *version_rotate(struct version_node *n, int direction);
+struct version_node *version_balance(struct version_node *n);
+struct version_node *version_insert_node(struct version_node *n, struct version_record *record, int *failed);
+struct node *version_append(struct version_node *n, struct node *tail, int *failed);
+void version_discard(struct version_node *n);
+void version_records_free(struct version_record **records, long int length);
+void version_release(struct version_node *n);
 /***************************************************************************************************/
 
 
@@ -122,54 +547,60 @@ void populate_node(struct node *n, char *first_name, char *last_name,
  * \param given - the given name to store in the list
  * \param assignments - the list of assignments for the given student
  * \param num_assignments - the length of the assignments list
- * \param name_order - which of the 2 names to use
+ * \param name_order - which of the 2 names to use, or SCORE (see insert_node)
  * \param sort_order - the direction of the sort \n
  *                   1 for ascending \n
  *                   -1 for descending
  * 
- * \return pointer to the head node
+ * \return pointer to the head node (the list is left as it is for ASSIGNMENT_SCORE)
  */
 struct node* insert(struct node* head, char *given, char *family, struct assignment *assignments,
                     long int num_assignments, int name_order, int sort_order){
 	struct node *tmp;
-	struct node *cursor;
-	struct node *cursor2;	
-	
-	cursor = head_pointer(head);
 
-	tmp = (struct node*) malloc(sizeof(struct node));
-	populate_node(tmp, given, family, assignments, num_assignments, name_order, sort_order);
+	/* the list doesn't record which assignment it was ranked on */
+	if (name_order == ASSIGNMENT_SCORE) return head;
 
-	if (head == NULL){
-		/* this means the list is empty, so just create a node, and add the value to it */
+	tmp = new_node(given, family, assignments, num_assignments, name_order, sort_order);
+
+	/* error check */
+	if (tmp == NULL) return tmp;
+
+	return insert_node(head, tmp, name_order, sort_order);
+}
+
+
+/*!
+ * \brief links an already populated node into its place in the list
+ *
+ * \param head - the head of the list (possibly NULL)
+ * \param tmp - the unlinked node
+ * \param name_order - which of the 2 names to use, or SCORE to place it by mean score
+ * \param sort_order - the direction of the sort
+ *
+ * \return pointer to the head node; for ASSIGNMENT_SCORE the list is left as it is, and tmp unlinked
+ */
+struct node *insert_node(struct node *head, struct node *tmp, int name_order, int sort_order){
+	if (name_order == ASSIGNMENT_SCORE){
+		/* the list doesn't record which assignment it was ranked on */
+		return head;
+	}else if (name_order == SCORE){
+		/* there are no kernels for scores; sort_list checks the ranking, as scores may have changed */
+		tmp->sort_key = SCORE;
+		tmp->sort_order = sort_order;
+		if (head != NULL) head = sort_list(head, SCORE, sort_order);
+		head = insert_by_score(head, tmp);
+	}else if (head == NULL){
+		/* this means the list is empty, so the node is the list */
 		head = tmp;
-		
-		/* error check */
-		if (head == NULL){
-			return head;
-		} 
-		
 	}else{
 		/* make sure the list is sorted the same way */
 		if (head->sort_key != name_order || head->sort_order != sort_order){
 			head = sort_list(head, name_order, sort_order);
 		}
 		
-		/* find the new location */		
-		if (sort_order == ASCEND){
-			cursor = location(head, given, family);
-		}else if (sort_order == DESCEND){
-			cursor = location(head, given, family);
-		}
-		
-		/* insert the new node in the correct location */
-		
-		/* error check */
-		if (tmp == NULL) return tmp;		
-		
-		place(given, family, cursor, tmp);
-		
-		
+		/* find the new location and insert the new node there, with the kernel for this ordering */
+		insert_kernels[name_order][sort_order == ASCEND](head, tmp);
 	}
 	return head_pointer(head);
 }
@@ -241,15 +672,16 @@ struct node *nth_node(struct node *head, int location){
  */
 struct node* find_by_name(struct node *head, char *name, int name_order){
 	struct node *cursor = head_pointer(head);
+	uint64_t prefix = key_prefix(name);
 	
 	/* I hate special cases, but this one is unavoidable in this situation */
 	if (name_order == GIVEN){
-		while(strcmp(name, cursor->first_name) < 0){
+		while(key_compare(prefix, name, cursor->key_prefix[GIVEN], cursor->first_name) < 0){
 			if (cursor->previous != NULL){
 				cursor = cursor->previous;
 			}
 		}
-		if (strcmp(name, cursor->first_name) > 0){
+		if (key_compare(prefix, name, cursor->key_prefix[GIVEN], cursor->first_name) > 0){
 			return NULL;
 		}else{
 			/* not <, not >, so must be == */
@@ -257,12 +689,12 @@ struct node* find_by_name(struct node *head, char *name, int name_order){
 		}
 	}
 	else if (name_order == FAMILY){
-		while(strcmp(name, cursor->last_name) < 0){
+		while(key_compare(prefix, name, cursor->key_prefix[FAMILY], cursor->last_name) < 0){
 			if (cursor->previous != NULL){
 				cursor = cursor->previous;
 			}
 		}
-		if (strcmp(name, cursor->last_name) > 0){
+		if (key_compare(prefix, name, cursor->key_prefix[FAMILY], cursor->last_name) > 0){
 			return NULL;
 		}else{
 			/* not <, not >, so must be == */
@@ -316,7 +748,10 @@ struct node* reverse_list(struct node *head){
  * resorts as needed, reversing or leaving alone as possible
  *
  * \param head - the head of the list
- * \param name_order - which of the 2 names to use
+ * \param name_order - which of the 2 names to use, or SCORE for the mean score (see
+ *                     sort_list_by_score to sort on one assignment; ASSIGNMENT_SCORE is rejected
+ *                     here, and the list left as it is). Scores can change in place, so a list
+ *                     marked SCORE is checked, and only left alone if it is still in order.
  * \param sort_order - the direction of the sort
  *                   1 for ascending
  *                   -1 for descending
@@ -328,8 +763,16 @@ struct node* sort_list(struct node *head, int name_order, int sort_order){
 	struct node* new_head = NULL;
 	struct node* cursor = head_pointer(head);
 	
+	if (name_order == ASSIGNMENT_SCORE) return cursor;
+
 	if(head != NULL){
-		if (head->sort_key == name_order){
+		if (name_order == SCORE){
+			/* the mark can't be trusted, set_score and the like don't move anyone */
+			new_head = (head->sort_key == SCORE && head->sort_order == sort_order &&
+			            list_in_order(cursor, SCORE, sort_order)) ? cursor
+			                                                      : sort_list_by_score(cursor, NULL, sort_order);
+		}
+		else if (head->sort_key == name_order){
 			/* sort key is same, so check for reversal or not */
 			if (head->sort_order == sort_order){
 				/* no change */
@@ -341,15 +784,8 @@ struct node* sort_list(struct node *head, int name_order, int sort_order){
 			}
 		}
 		else{
-			/* sort key is changed, so just create a new list */
-			while (cursor != NULL){
-				new_head = insert(new_head, cursor->first_name, cursor->last_name, cursor->assignments, 
-				                  cursor->num_assignments, name_order, sort_order);
-				cursor = cursor->previous;
-			}
-			
-			/* get rid of the original list */
-			delete_list(head);
+			/* sort key is changed, so sort the nodes we already have and relink them */
+			new_head = bulk_sort_list(cursor, name_order, sort_order);
 		}
 	}
 	
@@ -447,7 +883,8 @@ struct node* delete_list(struct node *head){
 
 /*!
  * \brief reads a well formatted file, and inserts all entries found into a list pointed to by head,
- * with the given sort order.
+ * with the given sort order. The records are chained onto the list as they are read, and the
+ * whole list is sorted once at the end.
  * 
  * \param head - pointer to a list (possibly NULL)
  * \param stream - open file stream in read mode
@@ -457,6 +894,23 @@ struct node* delete_list(struct node *head){
  * \return pointer to the head node
  */
 struct node *list_from_file(struct node *head, FILE *stream, int sort_key, int sort_order){
+	return bulk_sort_list(chain_from_file(head, stream, sort_key, sort_order), sort_key, sort_order);
+}
+
+
+/*!
+ * \brief reads a well formatted file as list_from_file does, but only chains the records onto the
+ * tail of the list in the order they are read, without sorting. The nodes are marked with the
+ * given sort order, so the caller must sort the list unless it knows the file was in that order.
+ *
+ * \param head - pointer to a list (possibly NULL)
+ * \param stream - open file stream in read mode
+ * \param sort_key - sort key to mark the new nodes with (nothing is read for ASSIGNMENT_SCORE)
+ * \param sort_order - sort order to mark the new nodes with
+ *
+ * \return pointer to the head node
+ */
+struct node *chain_from_file(struct node *head, FILE *stream, int sort_key, int sort_order){
 	int number_records = 0;
 	int number_pairs = 0;
 	char first_name[MAX_STRING_LENGTH];
@@ -465,6 +919,7 @@ struct node *list_from_file(struct node *head, FILE *stream, int sort_key, int s
 	double score;
 
 	int matched;
+	int complete;
 
 	char name_format[MAX_STRING_LENGTH];
 	char grade_format[MAX_STRING_LENGTH];
@@ -473,13 +928,22 @@ struct node *list_from_file(struct node *head, FILE *stream, int sort_key, int s
 
 	int match_count = 2;
 
-	/* generalize the formatting strings */
- 	snprintf(name_format, MAX_STRING_LENGTH, "%%%d[^\',\'],%%%d[^\',\']", MAX_STRING_LENGTH, MAX_STRING_LENGTH);
-	snprintf(grade_format, MAX_STRING_LENGTH, ",%%%d[^\',\'],%%lf", MAX_STRING_LENGTH);
+	struct node *tail = tail_pointer(head);
+	struct node *tmp;
+
+	/* the records could never be put in that order */
+	if (sort_key == ASSIGNMENT_SCORE) return head;
+
+	/* generalize the formatting strings, skipping the line break ahead of each record */
+ 	snprintf(name_format, MAX_STRING_LENGTH, " %%%d[^\',\'],%%%d[^\',\']", MAX_STRING_LENGTH - 1,
+	         MAX_STRING_LENGTH - 1);
+	snprintf(grade_format, MAX_STRING_LENGTH, ",%%%d[^\',\'],%%lf", MAX_STRING_LENGTH - 1);
 
 	matched = fscanf(stream, "%d,%d ", &number_records, &number_pairs);
 	if(matched == match_count){
-		assignments = (struct assignment *)malloc(sizeof(struct assignment) * number_pairs);
+		assignments = (struct assignment *)malloc(sizeof(struct assignment) * max(number_pairs, 1));
+		if (assignments == NULL) return head;
+
 		for(int i = 0; i < number_records; i++){
 			matched = fscanf(stream, name_format, first_name, last_name);
 
@@ -488,18 +952,36 @@ struct node *list_from_file(struct node *head, FILE *stream, int sort_key, int s
 				continue;
 			}
 
+			/* a record with a bad grade, or that memory runs out for, is skipped */
+			complete = 1;
 			for(int j = 0; j < number_pairs; j++){
+				assignments[j].name = NULL;
 				matched = fscanf(stream, grade_format, assignment, &score);
 				if (matched != match_count){
+					complete = 0;
 					continue;
 				}else{
-					assignments[j].name = (char *)malloc(min(MAX_STRING_LENGTH, strlen(assignment)));
-					strncpy(assignments[j].name, assignment, min(MAX_STRING_LENGTH, strlen(assignment)));
+					assignments[j].name = (char *)malloc(min(MAX_STRING_LENGTH, strlen(assignment) + 1));
+					if (assignments[j].name == NULL){
+						complete = 0;
+						continue;
+					}
+					strncpy(assignments[j].name, assignment, min(MAX_STRING_LENGTH, strlen(assignment) + 1));
 					assignments[j].value = score;
 				}
 			}
 			
-			head = insert(head, first_name, last_name, assignments, number_pairs, sort_key, sort_order);
+			/* chain the new node onto the tail, the caller puts it in its place */
+			tmp = complete ? new_node(first_name, last_name, assignments, number_pairs, sort_key, sort_order) : NULL;
+			if (tmp != NULL){
+				tmp->next = tail;
+				if (tail != NULL){
+					tail->previous = tmp;
+				}else{
+					head = tmp;
+				}
+				tail = tmp;
+			}
 
 			/* free up the assignments you malloc'd */
 			for(int j = 0; j < number_pairs; j++){
@@ -514,6 +996,298 @@ struct node *list_from_file(struct node *head, FILE *stream, int sort_key, int s
 }
 
 
+/*!
+ * \brief reads a well formatted file from a file descriptor, as list_from_file, with reading and
+ * parsing overlapped: a reader thread fills one of LOADER_BUFFERS buffers while this thread parses
+ * the other and builds the nodes. Memory used by the loader is bounded by the buffers plus one
+ * line. The new records are sorted into the list once at the end.
+ *
+ * \param head - pointer to a list (possibly NULL)
+ * \param fd - file descriptor open for reading
+ * \param sort_key - whether to sort on first or last name
+ * \param sort_order - whether to sort ascending or descending
+ * \param error - output parameter, set to 0 on success, or to an errno value (EINVAL for a bad
+ *                header, or for ASSIGNMENT_SCORE); on error the list is returned as it was given
+ *
+ * \return pointer to the head node
+ */
+struct node *list_from_fd(struct node *head, int fd, int sort_key, int sort_order, int *error){
+	struct loader loader;
+	struct loader_parse parse;
+	pthread_t reader;
+	char *start, *end, *newline;
+	int b = 0;
+	int finished = 0;
+
+	*error = 0;
+
+	if (sort_key == ASSIGNMENT_SCORE){
+		*error = EINVAL;
+		return head;
+	}
+
+	loader.fd = fd;
+	loader.error = 0;
+	loader.stop = 0;
+	for (int i = 0; i < LOADER_BUFFERS; ++i){
+		loader.buffers[i] = (char *)malloc(LOADER_BUFFER_SIZE);
+		loader.filled[i] = 0;
+		loader.ready[i] = 0;
+		if (loader.buffers[i] == NULL) *error = ENOMEM;
+	}
+
+	parse.records = NULL;
+	parse.tail = NULL;
+	parse.number_pairs = -1;
+	parse.assignments = NULL;
+	parse.line = NULL;
+	parse.line_length = 0;
+	parse.line_capacity = 0;
+	parse.sort_key = sort_key;
+	parse.sort_order = sort_order;
+
+	pthread_mutex_init(&loader.lock, NULL);
+	pthread_cond_init(&loader.changed, NULL);
+
+	if (*error == 0 && (*error = pthread_create(&reader, NULL, loader_read, &loader)) == 0){
+		while (!finished && *error == 0){
+			/* wait for the reader to hand over the next buffer */
+			pthread_mutex_lock(&loader.lock);
+			while (!loader.ready[b]){
+				pthread_cond_wait(&loader.changed, &loader.lock);
+			}
+			pthread_mutex_unlock(&loader.lock);
+
+			if (loader.filled[b] < 0){
+				*error = loader.error;
+				break;
+			}
+			finished = (loader.filled[b] == 0);
+
+			/* parse every complete line, carrying a partial line over to the next buffer */
+			start = loader.buffers[b];
+			end = start + loader.filled[b];
+			while (start < end && *error == 0){
+				newline = (char *)memchr(start, '\n', end - start);
+				if (newline == NULL){
+					*error = loader_carry(&parse, start, end - start);
+					break;
+				}
+
+				*newline = '\0';
+				if (parse.line_length > 0){
+					if ((*error = loader_carry(&parse, start, newline - start)) == 0){
+						*error = loader_parse_line(&parse, parse.line);
+					}
+					parse.line_length = 0;
+				}else{
+					*error = loader_parse_line(&parse, start);
+				}
+				start = newline + 1;
+			}
+
+			/* the last line need not end in a line break */
+			if (finished && parse.line_length > 0 && *error == 0){
+				*error = loader_parse_line(&parse, parse.line);
+			}
+
+			/* give the buffer back to the reader */
+			pthread_mutex_lock(&loader.lock);
+			loader.ready[b] = 0;
+			pthread_cond_broadcast(&loader.changed);
+			pthread_mutex_unlock(&loader.lock);
+
+			b = (b + 1) % LOADER_BUFFERS;
+		}
+
+		/* stop the reader if we are leaving early, and wait for it either way */
+		pthread_mutex_lock(&loader.lock);
+		loader.stop = 1;
+		pthread_cond_broadcast(&loader.changed);
+		pthread_mutex_unlock(&loader.lock);
+		pthread_join(reader, NULL);
+	}
+
+	if (*error == 0 && parse.number_pairs < 0){
+		/* not even a header */
+		*error = EINVAL;
+	}
+
+	pthread_mutex_destroy(&loader.lock);
+	pthread_cond_destroy(&loader.changed);
+	for (int i = 0; i < LOADER_BUFFERS; ++i){
+		free(loader.buffers[i]);
+	}
+	free(parse.assignments);
+	free(parse.line);
+
+	if (*error != 0){
+		delete_list(parse.records);
+		return head;
+	}
+
+	/* attach the new records after the old ones, and sort everything once */
+	if (parse.records != NULL){
+		struct node *tail = tail_pointer(head);
+		if (tail != NULL){
+			tail->previous = parse.records;
+			parse.records->next = tail;
+		}else{
+			head = parse.records;
+		}
+	}
+
+	return bulk_sort_list(head, sort_key, sort_order);
+}
+
+
+/*!
+ * \brief body of the reader thread for list_from_fd: fills the buffers in turn, each one as soon
+ * as the parser has handed it back. A filled count of 0 marks the end of the file, and -1 an error.
+ *
+ * \param arg - the struct loader shared with the parser
+ *
+ * \return NULL
+ */
+void *loader_read(void *arg){
+	struct loader *loader = (struct loader *)arg;
+	ssize_t got;
+	ssize_t filled;
+	int stop;
+	int b = 0;
+
+	while (1){
+		pthread_mutex_lock(&loader->lock);
+		while (loader->ready[b] && !loader->stop){
+			pthread_cond_wait(&loader->changed, &loader->lock);
+		}
+		/* the parser sets stop under the lock, so read it before letting go */
+		stop = loader->stop;
+		pthread_mutex_unlock(&loader->lock);
+		if (stop) break;
+
+		/* fill the whole buffer, unless the file ends first */
+		filled = 0;
+		while (filled < LOADER_BUFFER_SIZE){
+			got = read(loader->fd, loader->buffers[b] + filled, LOADER_BUFFER_SIZE - filled);
+			if (got < 0 && errno == EINTR) continue;
+			if (got <= 0) break;
+			filled += got;
+		}
+		if (got < 0){
+			loader->error = errno;
+			filled = -1;
+		}
+
+		pthread_mutex_lock(&loader->lock);
+		loader->filled[b] = filled;
+		loader->ready[b] = 1;
+		pthread_cond_broadcast(&loader->changed);
+		pthread_mutex_unlock(&loader->lock);
+
+		/* nothing more to read after the end or an error */
+		if (filled <= 0) break;
+
+		b = (b + 1) % LOADER_BUFFERS;
+	}
+
+	return NULL;
+}
+
+
+/*!
+ * \brief appends part of a line to the line being carried between buffers
+ *
+ * \param parse - the parser state
+ * \param text - the characters to append
+ * \param length - how many characters there are
+ *
+ * \return 0, or ENOMEM
+ */
+int loader_carry(struct loader_parse *parse, char *text, long int length){
+	char *grown;
+
+	if (parse->line_length + length + 1 > parse->line_capacity){
+		parse->line_capacity = 2 * (parse->line_length + length + 1);
+		grown = (char *)realloc(parse->line, parse->line_capacity);
+		if (grown == NULL) return ENOMEM;
+		parse->line = grown;
+	}
+
+	memcpy(parse->line + parse->line_length, text, length);
+	parse->line_length += length;
+	parse->line[parse->line_length] = '\0';
+
+	return 0;
+}
+
+
+/*!
+ * \brief parses one line of the file in place: the header the first time, and a record after that.
+ * Malformed records are skipped, as list_from_file does.
+ *
+ * \param parse - the parser state
+ * \param line - the line, without its line break (its commas are overwritten)
+ *
+ * \return 0, or an errno value
+ */
+int loader_parse_line(struct loader_parse *parse, char *line){
+	long int number_records;
+	char *fields[2];
+	char *end;
+	struct node *tmp;
+
+	/* skip leading blanks, and a carriage return at the end */
+	while (*line == ' ' || *line == '\t' || *line == '\r') ++line;
+	if (*line == '\0') return 0;
+	end = line + strlen(line) - 1;
+	if (*end == '\r') *end = '\0';
+
+	if (parse->number_pairs < 0){
+		if (sscanf(line, "%ld,%ld", &number_records, &parse->number_pairs) != 2 || parse->number_pairs < 0){
+			return EINVAL;
+		}
+		parse->assignments = (struct assignment *)malloc(max(parse->number_pairs, 1) * sizeof(struct assignment));
+		return (parse->assignments == NULL) ? ENOMEM : 0;
+	}
+
+	/* first and last name */
+	for (int i = 0; i < 2; ++i){
+		fields[i] = line;
+		line = strchr(line, ',');
+		if (line == NULL && (i == 0 || parse->number_pairs > 0)) return 0;
+		if (line != NULL) *line++ = '\0';
+	}
+
+	/* then the assignment, score pairs */
+	for (long int j = 0; j < parse->number_pairs; ++j){
+		parse->assignments[j].name = line;
+		line = strchr(line, ',');
+		if (line == NULL) return 0;
+		*line++ = '\0';
+
+		parse->assignments[j].value = strtod(line, &end);
+		if (end == line) return 0;
+		line = (*end == ',') ? end + 1 : end;
+	}
+
+	tmp = new_node(fields[0], fields[1], parse->assignments, parse->number_pairs, parse->sort_key,
+	               parse->sort_order);
+	if (tmp == NULL) return ENOMEM;
+
+	/* chain the new node onto the tail, it gets put in its place by the final sort */
+	tmp->next = parse->tail;
+	if (parse->tail != NULL){
+		parse->tail->previous = tmp;
+	}else{
+		parse->records = tmp;
+	}
+	parse->tail = tmp;
+
+	return 0;
+}
+
+
 /*!
  * \brief searches the list for a given student using the current sort key of the list, and returns
  * a pointer to their assignment list
@@ -531,7 +1305,8 @@ struct assignment *assignment_list(struct node *head, char *given, char *family,
 
 	if (head != NULL){
 		/* find by using the primary sort key as the passed name, and use the list to determine */
-		cursor = find_by_name(head, names[head->sort_key], head->sort_key);
+		cursor = (head->sort_key >= SCORE) ? find_student(head, given, family)
+		                                   : find_by_name(head, names[head->sort_key], head->sort_key);
 	}
 
 	/* assign the output parameter */
@@ -606,8 +1381,8 @@ struct stats class_statistics(struct node *head, char *assignment){
 			for (j = 0; j < cursor->num_assignments; ++j){
 
 				/* pulling out the values you care about*/
-				if(strcmp(assignments[i].name, assignment) == 0){
-					list[entry++] = assignments[i].value;
+				if(strcmp(assignments[j].name, assignment) == 0){
+					list[entry++] = assignments[j].value;
 					break;
 				}
 			}
@@ -729,284 +1504,3684 @@ double median(double *list, long int length){
 
 
 /*!
- * \brief return the head pointer
+ * \brief reads a well formatted file once, keeping only a sketch per assignment instead of
+ * building the list. Memory use depends on the number of assignments, never on the number of
+ * records, and the record count is read as a long int so archives past 2^31 records work.
+ * Assignments missing from a record are left out of that column.
  *
- * \param head - the head of the list
+ * \param stream - open file stream in read mode
+ * \param num_columns - output parameter to hold the number of columns (assignments) found
  *
- * \return pointer to the head node
+ * \return array of column sketches, to be released with free, or NULL on error
  */
-struct node* head_pointer(struct node *head){
-	struct node* cursor = head;
-	
-	if (head != NULL){
-		while (cursor->next != NULL){
-			cursor = cursor->next;
-		}
-	}
-	
-	return cursor;
+struct column_sketch *stream_statistics(FILE *stream, long int *num_columns){
+	long int number_records = 0;
+	long int number_pairs = 0;
+	char first_name[MAX_STRING_LENGTH];
+	char last_name[MAX_STRING_LENGTH];
+	char assignment[MAX_STRING_LENGTH];
+	double score;
+
+	char name_format[MAX_STRING_LENGTH];
+	char grade_format[MAX_STRING_LENGTH];
+
+	struct column_sketch *columns;
+	long int found = 0;
+	long int c;
+
+	*num_columns = 0;
+
+	/* generalize the formatting strings, as list_from_file */
+	snprintf(name_format, MAX_STRING_LENGTH, " %%%d[^\',\'],%%%d[^\',\']", MAX_STRING_LENGTH - 1,
+	         MAX_STRING_LENGTH - 1);
+	snprintf(grade_format, MAX_STRING_LENGTH, ",%%%d[^\',\'],%%lf", MAX_STRING_LENGTH - 1);
+
+	if (fscanf(stream, "%ld,%ld ", &number_records, &number_pairs) != 2 || number_pairs <= 0){
+		return NULL;
+	}
+
+	columns = (struct column_sketch *)malloc(number_pairs * sizeof(struct column_sketch));
+	if (columns == NULL) return NULL;
+
+	for (long int i = 0; i < number_records; ++i){
+		if (fscanf(stream, name_format, first_name, last_name) != 2){
+			/* out of records, whatever the header said */
+			break;
+		}
+
+		for (long int j = 0; j < number_pairs; ++j){
+			if (fscanf(stream, grade_format, assignment, &score) != 2){
+				break;
+			}
+
+			/* columns are usually in the same place on every line, so look there first */
+			c = j;
+			if (c >= found || strcmp(columns[c].name, assignment) != 0){
+				for (c = 0; c < found && strcmp(columns[c].name, assignment) != 0; ++c);
+			}
+
+			if (c == found){
+				if (found == number_pairs) continue;
+				sketch_init(&columns[found++], assignment);
+			}
+
+			sketch_add(&columns[c], score);
+		}
+	}
+
+	*num_columns = found;
+
+	return columns;
 }
 
+
 /*!
- * \brief return the tail pointer
+ * \brief sets up an empty sketch for a column
  *
- * \param head - the head of the list
+ * \param sketch - the sketch to set up
+ * \param name - name of the assignment the column holds
+ */
+void sketch_init(struct column_sketch *sketch, char *name){
+	snprintf(sketch->name, sizeof sketch->name, "%s", name);
+	sketch->count = 0;
+	sketch->sum = 0.0;
+	sketch->sum_squares = 0.0;
+	sketch->low = DBL_MAX;
+	sketch->high = -DBL_MAX;
+	memset(sketch->bins, 0, sizeof(sketch->bins));
+}
+
+
+/*!
+ * \brief adds a single score to a sketch
  *
- * \return pointer to the tail node
+ * \param sketch - the sketch to add to
+ * \param value - the score
  */
-struct node* tail_pointer(struct node *head){
-	struct node* cursor = head;
-	
-	if (head != NULL){
-		while (cursor->previous != NULL){
-			cursor = cursor->previous;
-		}
-	}
-	
-	return cursor;
+void sketch_add(struct column_sketch *sketch, double value){
+	long int bin = (long int)floor((value - SKETCH_LOW) * SKETCH_RESOLUTION + 0.5);
+
+	sketch->count++;
+	sketch->sum += value;
+	sketch->sum_squares += (long double)value * value;
+	sketch->low = min(sketch->low, value);
+	sketch->high = max(sketch->high, value);
+
+	/* out of range scores land in the end bins, and come back out as low or high */
+	sketch->bins[min(max(bin, 0), SKETCH_BINS - 1)]++;
 }
 
 
 /*!
- * \brief A funtion to find the location to insert into the list
+ * \brief descriptive statistics of a column, as class_statistics would give for the same scores
  *
- * \param head - the head of the list
- * \param family - the family name to look for
- * \param given - the given name to look for
+ * \param sketch - the sketch in question
  *
- * \return pointer to the node AFTER where the insertion should occur
+ * \return stats struct containing descriptive statistics
  */
-struct node *location(struct node* head, char *given, char *family){
-	struct node *cursor = head;
-	
-	/* error checking */
-	if (cursor != NULL){
-		
-		/* decide which sort key to use */
-		if (cursor->sort_key == GIVEN){
-			while(location_compare(given, cursor->first_name, cursor->sort_order)){
-				/* given name is greater/less than current node, so move */
-				if (cursor->previous != NULL){
-					cursor = cursor->previous;
-				}
-				else{
-					break;
-				}
-			}
-		}else{
-			while(location_compare(family, cursor->last_name, cursor->sort_order)){
-				/* family name is greater/less than current node, so move */
-				if (cursor->previous != NULL){
-					cursor = cursor->previous;
-				}
-				else{
-					break;
-				}
+struct stats sketch_stats(struct column_sketch *sketch){
+	struct stats tmp;
+	long double n = sketch->count;
+
+	tmp.mean = (double)(sketch->sum / n);
+	/* sample standard deviation, as stddev() */
+	tmp.stddev = (double)sqrtl((sketch->sum_squares - sketch->sum * sketch->sum / n) / (n - 1));
+	tmp.median = sketch_quantile(sketch, 0.5);
+
+	return tmp;
+}
+
+
+/*!
+ * \brief a quantile of a column, interpolating between the two nearest ranks, so the 0.5 quantile
+ * agrees with median(). Exact for scores on the SKETCH_RESOLUTION grid.
+ *
+ * \param sketch - the sketch in question
+ * \param p - the quantile wanted, from 0 to 1
+ *
+ * \return the quantile
+ */
+double sketch_quantile(struct column_sketch *sketch, double p){
+	double position = p * (sketch->count - 1);
+	long int rank = (long int)floor(position);
+	double low, high;
+
+	if (sketch->count == 0) return NAN;
+
+	low = sketch_rank(sketch, rank);
+	high = (rank + 1 < sketch->count) ? sketch_rank(sketch, rank + 1) : low;
+
+	return low + (high - low) * (position - rank);
+}
+
+
+/*!
+ * \brief the score at a given rank (0 based) within a column
+ *
+ * \param sketch - the sketch in question
+ * \param rank - the rank wanted
+ *
+ * \return the score at that rank
+ */
+double sketch_rank(struct column_sketch *sketch, long int rank){
+	long int seen = 0;
+	long int bin;
+
+	for (bin = 0; bin < SKETCH_BINS - 1; ++bin){
+		seen += sketch->bins[bin];
+		if (seen > rank) break;
+	}
+
+	/* clamping puts scores from the end bins back at their real extremes */
+	return min(max(SKETCH_LOW + (double)bin / SKETCH_RESOLUTION, sketch->low), sketch->high);
+}
+
+
+/*!
+ * \brief writes column sketches to a stream, so they can be merged elsewhere. Sums are written as
+ * hex floats and only non empty bins are written, so the round trip is exact and compact.
+ *
+ * \param stream - open file stream in write mode
+ * \param columns - array of column sketches
+ * \param num_columns - length of the array
+ */
+void sketch_write(FILE *stream, struct column_sketch *columns, long int num_columns){
+	long int used;
+
+	fprintf(stream, "%ld\n", num_columns);
+
+	for (long int c = 0; c < num_columns; ++c){
+		used = 0;
+		for (long int bin = 0; bin < SKETCH_BINS; ++bin){
+			used += (columns[c].bins[bin] != 0);
+		}
+
+		fprintf(stream, "%s\n%ld %La %La %a %a %ld\n", columns[c].name, columns[c].count,
+		        columns[c].sum, columns[c].sum_squares, columns[c].low, columns[c].high, used);
+
+		for (long int bin = 0; bin < SKETCH_BINS; ++bin){
+			if (columns[c].bins[bin] != 0){
+				fprintf(stream, "%ld %ld\n", bin, columns[c].bins[bin]);
 			}
 		}
 	}
-	
-	/* will still be null if it started out that way */
-	return cursor;
-	
 }
 
 
 /*!
- * \brief A funtion to deal with special case tail logic
+ * \brief reads column sketches written by sketch_write
  *
- * \param tmp - the node to insert into the list
- * \param cursor - the node adjacent to where tmp needs to be inserted (should be the tail)
- * \param family - the family name to store in the list
- * \param given - the given name to store in the list
+ * \param stream - open file stream in read mode
+ * \param num_columns - output parameter to hold the number of columns read
+ *
+ * \return array of column sketches, to be released with free, or NULL on error
  */
-void place(char *given, char *family, struct node *cursor, struct node *tmp){
-	
-	/* I hate special cases, so I work around them */
-	/* this works because I carefully chose the values to be used for sort_key */
-	char *names[] = {given, family};
-	char *node_names[] = {cursor->first_name, cursor->last_name};
-	
-	if (place_compare(node_names[cursor->sort_key], names[cursor->sort_key], cursor->sort_order)){
-		/* does it go before the tail? */
-		tmp->previous = NULL;
-		cursor->previous = tmp;
-		tmp->next = cursor;
-	}else{
-		/* or after? */
-		tmp->previous = cursor;
-		tmp->next = cursor->next;
-		if (cursor->next != NULL){
-			cursor->next->previous = tmp;
+struct column_sketch *sketch_read(FILE *stream, long int *num_columns){
+	struct column_sketch *columns;
+	char name_format[MAX_STRING_LENGTH];
+	char name[MAX_STRING_LENGTH];
+	long int used, bin, count;
+	int failed = 0;
+
+	*num_columns = 0;
+
+	if (fscanf(stream, "%ld", num_columns) != 1 || *num_columns < 0) return NULL;
+
+	/* always hand back something that can be freed, even with no columns */
+	columns = (struct column_sketch *)malloc(max(*num_columns, 1) * sizeof(struct column_sketch));
+	if (columns == NULL) return NULL;
+
+	snprintf(name_format, MAX_STRING_LENGTH, " %%%d[^\n]", MAX_STRING_LENGTH - 1);
+
+	for (long int c = 0; c < *num_columns && !failed; ++c){
+		if (fscanf(stream, name_format, name) != 1){
+			failed = 1;
+			break;
+		}
+
+		sketch_init(&columns[c], name);
+		if (fscanf(stream, "%ld %La %La %la %la %ld", &columns[c].count, &columns[c].sum,
+		           &columns[c].sum_squares, &columns[c].low, &columns[c].high, &used) != 6){
+			failed = 1;
+			break;
+		}
+
+		for (long int i = 0; i < used; ++i){
+			if (fscanf(stream, "%ld %ld", &bin, &count) != 2 || bin < 0 || bin >= SKETCH_BINS){
+				failed = 1;
+				break;
+			}
+			columns[c].bins[bin] = count;
 		}
-		cursor->next = tmp;
 	}
+
+	if (failed){
+		/* the stream ended early or was garbled, so the sketches are incomplete */
+		free(columns);
+		*num_columns = 0;
+		return NULL;
+	}
+
+	return columns;
 }
 
-/* next 2 functions are used to remove special case logic from location/place functions */
+
 /*!
- * \brief remove special case logic from location, by abstracting it out
- * 
- * \param name - name in node to insert 
- * \param name2 - name in list node to compare
- * \param direction - which ordering to use 
+ * \brief merges one sketch of a column into another. The result is exactly the sketch that would
+ * have been built from both sets of scores, bins and counts included.
  *
- * \return result of comparison between \a name and \a name2, based on \a direction
+ * \param into - the sketch to merge into
+ * \param from - the sketch to merge from
  */
-int location_compare(char *name, char *name2, int direction){
-	if (direction == DESCEND){
-		return (strcmp(name, name2) < 0);
-	}else{
-		return (strcmp(name, name2) > 0);
+void sketch_merge(struct column_sketch *into, struct column_sketch *from){
+	into->count += from->count;
+	into->sum += from->sum;
+	into->sum_squares += from->sum_squares;
+	into->low = min(into->low, from->low);
+	into->high = max(into->high, from->high);
+
+	for (long int bin = 0; bin < SKETCH_BINS; ++bin){
+		into->bins[bin] += from->bins[bin];
 	}
 }
 
+
 /*!
- * \brief remove special case logic from place, by abstracting it out
- * 
- * \param name - name in node to insert 
- * \param name2 - name in list node to compare
- * \param direction - which ordering to use
+ * \brief merges a set of column sketches into another, matching columns up by name and adding
+ * any new columns onto the end
+ *
+ * \param columns - array of column sketches to merge into (possibly NULL)
+ * \param num_columns - length of \a columns, updated to the merged length
+ * \param more - array of column sketches to merge from
+ * \param num_more - length of \a more
  *
- * \return result of comparison between \a name and \a name2, based on \a direction
+ * \return the (possibly moved) merged array, or NULL on allocation failure
  */
-int place_compare(char *name, char *name2, int direction){
-	if (direction == ASCEND){
-		return (strcmp(name, name2) < 0);
-	}else{
-		return (strcmp(name, name2) > 0);
+struct column_sketch *sketch_merge_columns(struct column_sketch *columns, long int *num_columns,
+                                           struct column_sketch *more, long int num_more){
+	struct column_sketch *grown;
+	long int c;
+
+	for (long int m = 0; m < num_more; ++m){
+		for (c = 0; c < *num_columns && strcmp(columns[c].name, more[m].name) != 0; ++c);
+
+		if (c == *num_columns){
+			grown = (struct column_sketch *)realloc(columns, (c + 1) * sizeof(struct column_sketch));
+			if (grown == NULL){
+				free(columns);
+				return NULL;
+			}
+			columns = grown;
+			sketch_init(&columns[c], more[m].name);
+			(*num_columns)++;
+		}
+
+		sketch_merge(&columns[c], &more[m]);
 	}
+
+	return columns;
 }
 
 
 /*!
- * remove the nth element from the list and return the pointer to the (possibly new) head
+ * \brief statistics over several shard files at once. One worker process is forked per file,
+ * each streams its shard with stream_statistics and sends its sketches back over a pipe, and the
+ * sketches are merged exactly into class wide columns.
  *
- * \param head - the head of the list
- * \param location - the location to remove
+ * \param files - names of the shard files
+ * \param num_files - how many shard files there are
+ * \param num_columns - output parameter to hold the number of columns found
  *
- * \return pointer to the head node
+ * \return array of merged column sketches, to be released with free, or NULL if any shard failed
  */
-struct node* delete_nth(struct node *head, int location){
-	
-	if (head != NULL){
+struct column_sketch *sharded_statistics(char **files, int num_files, long int *num_columns){
+	struct column_sketch *columns = NULL;
+	struct column_sketch *shard;
+	long int shard_columns;
+	pid_t *workers = (pid_t *)malloc(num_files * sizeof(pid_t));
+	FILE **results = (FILE **)malloc(num_files * sizeof(FILE *));
+	int channel[2];
+	int status;
+	int failed = 0;
 
-	
-		struct node *cursor = head_pointer(head);
-		int i;
+	*num_columns = 0;
 
-		if (location >= 0){
-			for (i = 0; i < location; ++i){
-				if (cursor->previous != NULL){
-					cursor = cursor->previous;	
-				}
-			}
+	if (workers == NULL || results == NULL){
+		free(workers);
+		free(results);
+		return NULL;
+	}
+
+	/* don't let the workers inherit (and repeat) anything still buffered */
+	fflush(NULL);
+
+	for (int i = 0; i < num_files; ++i){
+		workers[i] = -1;
+		results[i] = NULL;
+
+		if (pipe(channel) != 0){
+			failed = 1;
+			continue;
 		}
-	
-		/* remove the node */
-		if (list_length(head) > 1){
-			/* if the length of the list is greater than 1, remove the node */
-			if (cursor->next != NULL) {
-				cursor->next->previous = cursor->previous;	
-			}else{
-				/* is the head, so we need to define a new head */
-				head = cursor->previous;
-				if (head->previous != NULL){
-					head->previous->next = NULL;
-				}
-			}
-			if (cursor->previous != NULL){
-				cursor->previous->next = cursor->next;	
+
+		workers[i] = fork();
+		if (workers[i] == 0){
+			/* worker: stream the shard, send the sketches, and leave without running atexit */
+			FILE *shard_file = fopen(files[i], "r");
+			FILE *out = fdopen(channel[1], "w");
+			close(channel[0]);
+
+			if (shard_file == NULL || out == NULL) _exit(1);
+
+			shard = stream_statistics(shard_file, &shard_columns);
+			if (shard == NULL) _exit(1);
+
+			sketch_write(out, shard, shard_columns);
+			_exit((fclose(out) == 0) ? 0 : 1);
+		}
+
+		/* coordinator: keep only the read end */
+		close(channel[1]);
+		if (workers[i] < 0){
+			close(channel[0]);
+			failed = 1;
+		}else{
+			results[i] = fdopen(channel[0], "r");
+		}
+	}
+
+	/* every worker is already running, so gather their results in order */
+	for (int i = 0; i < num_files; ++i){
+		if (results[i] != NULL){
+			shard = sketch_read(results[i], &shard_columns);
+			fclose(results[i]);
+
+			if (shard == NULL){
+				failed = 1;
 			}else{
-				/* is the tail, and next exists */
-				cursor->next->previous = NULL;
+				columns = sketch_merge_columns(columns, num_columns, shard, shard_columns);
+				free(shard);
 			}
-		} else{
-			/* otherwise it's just the head */
-			head = NULL;
-		}  
-	
-	
-		/* free up the names */
-		free(cursor->first_name);
-		free(cursor->last_name);
-		/* don't forget to free up each of the assignment names */
-		if (cursor->assignments != NULL){
-			for (int i = 0; i < cursor->num_assignments; ++i){
-				free(cursor->assignments[i].name);
+		}
+
+		if (workers[i] > 0){
+			if (waitpid(workers[i], &status, 0) != workers[i] || !WIFEXITED(status) ||
+			    WEXITSTATUS(status) != 0){
+				failed = 1;
 			}
 		}
-		/* then the assignment list itself */
-		free(cursor->assignments);
-		/* and finally the node itself */
-		free(cursor);
 	}
-	
-	return head;
+
+	free(workers);
+	free(results);
+
+	if (failed){
+		free(columns);
+		*num_columns = 0;
+		return NULL;
+	}
+
+	return columns;
 }
 
 
 /*!
- * \brief A funtion to add the value to a given list, with a specified sort order
- * \param n - pointer to the node in question
- * \param last_name - the family name to store in the node
- * \param first_name - the given name to store in the node
- * \param assignments - the list of assignments for the given student
- * \param num_assignments - the length of the assignments list
- * \param sort_key - which of the 2 names to use
- * \param sort_order - the direction of the sort
- *                   1 for ascending
- *                   -1 for descending
+ * \brief descriptive statistics over every shard for a given assignment name, as class_statistics
+ * would give over the concatenated shards (counting only students that have the assignment)
+ *
+ * \param files - names of the shard files
+ * \param num_files - how many shard files there are
+ * \param assignment - assignment in question
+ *
+ * \return stats struct containing descriptive statistics, all NAN if unavailable
  */
-void populate_node(struct node *n, char *first_name, char *last_name,
-                   struct assignment *assignments, long int num_assignments, 
-                   int sort_key, int sort_order){
-	int first_name_length = min(strlen(first_name) + 1, MAX_STRING_LENGTH);
-	int last_name_length = min(strlen(last_name) + 1, MAX_STRING_LENGTH);
-	int assignment_name_length = 0;
-	
-	if (n != NULL){
-		/* sets the first name */
-		n->first_name = (char *)malloc(first_name_length);
-		strncpy(n->first_name, first_name, first_name_length);
-		
-		/* do the same for last name */
-		n->last_name = (char *)malloc(last_name_length);
-		strncpy(n->last_name, last_name, last_name_length);
-		
-		/* store the sorting information */
-		n->sort_order = sort_order;
-		n->sort_key = sort_key;
-		
-		/* store the assignment count */
-		n->num_assignments = num_assignments;
-		
-		/* malloc the assignment array */
-		n->assignments = (struct assignment *)malloc(num_assignments * sizeof(struct assignment));
-		
-		if (assignments != NULL){
-			for (int i = 0; i < num_assignments; ++i){
-				/* determine the length of the assignment name */
-				assignment_name_length = min(strlen(assignments[i].name), 
-				                             MAX_STRING_LENGTH);
-				/* and allocate storage for it */
-				n->assignments[i].name = (char *)malloc(assignment_name_length);
-				
-				/* then copy it into its proper place */
-				strncpy(n->assignments[i].name, 
-				        assignments[i].name, 
-				        assignment_name_length);
-				
-				n->assignments[i].value = assignments[i].value;
-			} /* for */
-		} /* if (assignments != NULL) */
-		
-		/* we don't know where these should point yet, so just NULL them out */
-		n->next = NULL;
-		n->previous = NULL;
-	} /* if (n != NULL) */
-	
-	
-	return;
+struct stats sharded_class_statistics(char **files, int num_files, char *assignment){
+	struct stats tmp = {NAN, NAN, NAN};
+	long int num_columns;
+	struct column_sketch *columns = sharded_statistics(files, num_files, &num_columns);
+
+	for (long int c = 0; c < num_columns; ++c){
+		if (strcmp(columns[c].name, assignment) == 0){
+			tmp = sketch_stats(&columns[c]);
+			break;
+		}
+	}
+
+	free(columns);
+
+	return tmp;
 }
-#endif
\ No newline at end of file
+
+
+/*!
+ * \brief packs the names and scores of a list into a score table: one 16 bit fixed point column per
+ * assignment any student has, with a scale chosen per column and PACKED_MISSING for students
+ * without the assignment. Rows follow the list order. Scores below zero are stored as zero.
+ *
+ * The table is built as a copy, so both exist until the list is freed. Once it is, a grade costs
+ * 2 bytes rather than the 16 of struct assignment plus its name string (column names are kept
+ * once per table), and a student costs their names and two pointers rather than a node.
+ *
+ * \param head - the head of the list
+ *
+ * \return pointer to the new table, or NULL if the list is empty or memory runs out
+ */
+struct score_table *score_table_from_list(struct node *head){
+	struct node *first = head_pointer(head);
+	struct node *cursor;
+	struct score_table *t;
+	struct packed_column *grown;
+	double *highest = NULL;
+	double *grown_highest;
+	long int capacity = 0;
+	char *store;
+	size_t store_length = 0;
+	long int i, a, c;
+	int name_length;
+
+	if (first == NULL) return NULL;
+
+	t = (struct score_table *)calloc(1, sizeof(struct score_table));
+	if (t == NULL) return NULL;
+
+	for (cursor = first; cursor != NULL; cursor = cursor->previous){
+		store_length += strlen(cursor->first_name) + strlen(cursor->last_name) + 2;
+		t->rows++;
+	}
+
+	t->first_names = (char **)malloc(t->rows * sizeof(char *));
+	t->last_names = (char **)malloc(t->rows * sizeof(char *));
+	t->name_store = (char *)malloc(store_length);
+	if (t->first_names == NULL || t->last_names == NULL || t->name_store == NULL){
+		score_table_free(t);
+		return NULL;
+	}
+
+	store = t->name_store;
+	for (i = 0, cursor = first; cursor != NULL; ++i, cursor = cursor->previous){
+		name_length = strlen(cursor->first_name) + 1;
+		t->first_names[i] = memcpy(store, cursor->first_name, name_length);
+		store += name_length;
+		name_length = strlen(cursor->last_name) + 1;
+		t->last_names[i] = memcpy(store, cursor->last_name, name_length);
+		store += name_length;
+	}
+
+	/* the first pass collects every assignment anyone has, and the highest score in each */
+	for (cursor = first; cursor != NULL; cursor = cursor->previous){
+		for (a = 0; a < cursor->num_assignments; ++a){
+			char *name = cursor->assignments[a].name;
+
+			/* students usually list their assignments in the same order, so look there first */
+			c = (a < t->num_columns && strcmp(t->columns[a].name, name) == 0) ? a
+			                                                                  : packed_column_index(t, name);
+			if (c < 0){
+				if (t->num_columns == capacity){
+					capacity = (capacity == 0) ? 16 : 2 * capacity;
+					grown = (struct packed_column *)realloc(t->columns, capacity * sizeof(struct packed_column));
+					if (grown != NULL) t->columns = grown;
+					grown_highest = (double *)realloc(highest, capacity * sizeof(double));
+					if (grown_highest != NULL) highest = grown_highest;
+					if (grown == NULL || grown_highest == NULL){
+						free(highest);
+						score_table_free(t);
+						return NULL;
+					}
+				}
+
+				/* count the column first, so score_table_free sees it even if it is left half built */
+				c = t->num_columns++;
+				t->columns[c].scores = NULL;
+				t->columns[c].name = (char *)malloc(strlen(name) + 1);
+				if (t->columns[c].name == NULL){
+					free(highest);
+					score_table_free(t);
+					return NULL;
+				}
+				strcpy(t->columns[c].name, name);
+				highest[c] = 0.0;
+			}
+			highest[c] = max(highest[c], cursor->assignments[a].value);
+		}
+	}
+
+	/* the finest of 1/100, 1/10 or 1 point that still fits the highest score */
+	for (c = 0; c < t->num_columns; ++c){
+		for (t->columns[c].scale = 100.0; t->columns[c].scale > 1.0 &&
+		     highest[c] * t->columns[c].scale > PACKED_MISSING - 1; t->columns[c].scale /= 10.0);
+		t->columns[c].scores = (uint16_t *)malloc(t->rows * sizeof(uint16_t));
+		if (t->columns[c].scores == NULL){
+			free(highest);
+			score_table_free(t);
+			return NULL;
+		}
+	}
+	free(highest);
+
+	/* the second pass goes a student at a time too, so each node is visited once */
+	for (i = 0, cursor = first; cursor != NULL; ++i, cursor = cursor->previous){
+		for (c = 0; c < t->num_columns; ++c){
+			a = packed_find(cursor, t->columns[c].name, c);
+			t->columns[c].scores[i] = (a < 0) ? PACKED_MISSING
+			                          : packed_encode(cursor->assignments[a].value, t->columns[c].scale);
+		}
+	}
+
+	return t;
+}
+
+
+/*!
+ * \brief releases a score table (the list it was built from, if still around, is untouched)
+ *
+ * \param t - the table to free
+ */
+void score_table_free(struct score_table *t){
+	if (t == NULL) return;
+
+	for (long int c = 0; c < t->num_columns; ++c){
+		free(t->columns[c].name);
+		free(t->columns[c].scores);
+	}
+	free(t->columns);
+	free(t->first_names);
+	free(t->last_names);
+	free(t->name_store);
+	free(t);
+}
+
+
+/*!
+ * \brief find a column of a score table by assignment name
+ *
+ * \param t - the table to search
+ * \param assignment - name of the assignment
+ *
+ * \return index of the column, or -1 if not found
+ */
+long int packed_column_index(struct score_table *t, char *assignment){
+	for (long int c = 0; c < t->num_columns; ++c){
+		if (strcmp(t->columns[c].name, assignment) == 0){
+			return c;
+		}
+	}
+
+	return -1;
+}
+
+
+/*!
+ * \brief find an assignment of a student, trying the expected position first
+ *
+ * \param n - the student
+ * \param assignment - name of the assignment
+ * \param guess - where the assignment usually is
+ *
+ * \return index into the assignments array, or -1 if not found
+ */
+long int packed_find(struct node *n, char *assignment, long int guess){
+	if (guess < n->num_assignments && strcmp(n->assignments[guess].name, assignment) == 0){
+		return guess;
+	}
+
+	return assignment_index(n, assignment);
+}
+
+
+/*!
+ * \brief encode a score as a fixed point code
+ *
+ * \param value - the score
+ * \param scale - codes per point
+ *
+ * \return the code, clamped to the representable range
+ */
+uint16_t packed_encode(double value, double scale){
+	double code = floor(value * scale + 0.5);
+
+	return (uint16_t)min(max(code, 0.0), (double)(PACKED_MISSING - 1));
+}
+
+
+/*!
+ * \brief Returns the statistical mean of a packed column, counting missing grades as 0 as
+ * class_statistics does. The codes are summed as integers, so the result is exact and the same on
+ * every run.
+ *
+ * \param scores - list of codes we are interested in
+ * \param length - how many codes there are
+ * \param scale - codes per point
+ *
+ * \return statistical mean, as double
+ */
+double packed_mean(uint16_t *scores, long int length, double scale){
+	uint64_t total = 0;
+
+	for (long int i = 0; i < length; ++i){
+		if (scores[i] != PACKED_MISSING){
+			total += scores[i];
+		}
+	}
+
+	return (double)total / ((double)length * scale);
+}
+
+
+/*!
+ * \brief Calculates the (sample) standard deviation of a packed column, counting missing grades
+ * as 0. The sum runs in a fixed order, so results are reproducible bit for bit.
+ *
+ * \param scores - list of codes we are interested in
+ * \param length - how many codes there are
+ * \param scale - codes per point
+ *
+ * \return standard deviation, as double
+ */
+double packed_stddev(uint16_t *scores, long int length, double scale){
+	double mu = packed_mean(scores, length, scale) * scale;
+	double sigma_2 = 0.0;
+	double code;
+
+	/* work in codes, and only scale back at the end */
+	for (long int i = 0; i < length; ++i){
+		code = (scores[i] == PACKED_MISSING) ? 0.0 : scores[i];
+		sigma_2 += (code - mu) * (code - mu);
+	}
+
+	sigma_2 /= (length - 1);
+
+	return sqrt(sigma_2) / scale;
+}
+
+
+/*!
+ * \brief returns the statistical median of a packed column, counting missing grades as 0. Codes
+ * are counted rather than sorted, so the column is left as it is.
+ *
+ * \param scores - list of codes we are interested in
+ * \param length - how many codes there are
+ * \param scale - codes per point
+ *
+ * \return statistical median, as double, or NAN if there are no codes or memory runs out
+ */
+double packed_median(uint16_t *scores, long int length, double scale){
+	long int *counts;
+	long int count = length;
+	long int seen = 0;
+	long int low = -1;
+	long int high = -1;
+	uint16_t highest = 0;
+
+	if (count == 0) return NAN;
+
+	for (long int i = 0; i < length; ++i){
+		if (scores[i] != PACKED_MISSING){
+			highest = max(highest, scores[i]);
+		}
+	}
+
+	counts = (long int *)calloc(highest + 1, sizeof(long int));
+	if (counts == NULL) return NAN;
+
+	for (long int i = 0; i < length; ++i){
+		counts[(scores[i] == PACKED_MISSING) ? 0 : scores[i]]++;
+	}
+
+	/* find the codes at the two middle ranks (the same rank, for an odd count) */
+	for (long int code = 0; code <= highest && high < 0; ++code){
+		seen += counts[code];
+		if (low < 0 && seen > (count - 1) / 2) low = code;
+		if (seen > count / 2) high = code;
+	}
+
+	free(counts);
+
+	return (double)(low + high) / (2.0 * scale);
+}
+
+
+/*!
+ * \brief descriptive statistics over the whole class for a given assignment, straight from a
+ * score table. As in class_statistics, a student without the assignment counts as a 0, so an
+ * assignment nobody has gives all zeros.
+ *
+ * \param t - the score table
+ * \param assignment - assignment in question
+ *
+ * \return stats struct containing descriptive statistics
+ */
+struct stats packed_class_statistics(struct score_table *t, char *assignment){
+	struct stats tmp = {0.0, 0.0, 0.0};
+	long int c = packed_column_index(t, assignment);
+
+	if (c >= 0){
+		tmp.mean = packed_mean(t->columns[c].scores, t->rows, t->columns[c].scale);
+		tmp.stddev = packed_stddev(t->columns[c].scores, t->rows, t->columns[c].scale);
+		tmp.median = packed_median(t->columns[c].scores, t->rows, t->columns[c].scale);
+	}
+
+	return tmp;
+}
+
+
+/*!
+ * \brief return the head pointer
+ *
+ * \param head - the head of the list
+ *
+ * \return pointer to the head node
+ */
+struct node* head_pointer(struct node *head){
+	struct node* cursor = head;
+	
+	if (head != NULL){
+		while (cursor->next != NULL){
+			cursor = cursor->next;
+		}
+	}
+	
+	return cursor;
+}
+
+/*!
+ * \brief return the tail pointer
+ *
+ * \param head - the head of the list
+ *
+ * \return pointer to the tail node
+ */
+struct node* tail_pointer(struct node *head){
+	struct node* cursor = head;
+	
+	if (head != NULL){
+		while (cursor->previous != NULL){
+			cursor = cursor->previous;
+		}
+	}
+	
+	return cursor;
+}
+
+
+/*!
+ * \brief A funtion to find the location to insert into the list
+ *
+ * \param head - the head of the list
+ * \param family - the family name to look for
+ * \param given - the given name to look for
+ *
+ * \return pointer to the node AFTER where the insertion should occur
+ */
+struct node *location(struct node* head, char *given, char *family){
+	char *names[] = {given, family};
+	
+	/* error checking, and a list sorted on a score has no place for a name */
+	if (head == NULL || head->sort_key >= SCORE) return NULL;
+	
+	/* a single dispatch, to the search kernel for the sort key and order of this list */
+	return location_kernels[head->sort_key][head->sort_order == ASCEND](head, key_prefix(names[head->sort_key]),
+	                                                                    names[head->sort_key]);
+}
+
+
+/*!
+ * \brief true when a name belongs further down a list than the node it was compared to
+ *
+ * \param ORDER - the sort order of the list
+ * \param comp - result of key_compare(name, node name)
+ */
+#define KERNEL_AFTER(ORDER, comp) (((ORDER) == ASCEND) ? ((comp) > 0) : ((comp) < 0))
+
+/*!
+ * \brief generates the search and insertion kernels for one sort key and order, so both are fixed
+ * at compile time instead of being tested at every node. Generates:
+ *
+ * location_SUFFIX(head, prefix, name) - as location(), for a name and its key prefix \n
+ * insert_SUFFIX(head, tmp) - finds the place for the populated node \a tmp and links it in
+ *
+ * \param SUFFIX - suffix of the generated function names
+ * \param FIELD - the name compared, first_name or last_name
+ * \param KEY - the matching sort key, GIVEN or FAMILY
+ * \param ORDER - the sort order, ASCEND or DESCEND
+ */
+#define LIST_KERNELS(SUFFIX, FIELD, KEY, ORDER)                                                     \
+struct node *location_##SUFFIX(struct node *head, uint64_t prefix, char *name){                     \
+	struct node *cursor = head;                                                                 \
+                                                                                                    \
+	/* name is greater/less than current node, so move */                                      \
+	while (cursor->previous != NULL &&                                                          \
+	       KERNEL_AFTER(ORDER, key_compare(prefix, name, cursor->key_prefix[KEY], cursor->FIELD))){ \
+		cursor = cursor->previous;                                                          \
+	}                                                                                           \
+                                                                                                    \
+	return cursor;                                                                              \
+}                                                                                                   \
+                                                                                                    \
+void insert_##SUFFIX(struct node *head, struct node *tmp){                                          \
+	struct node *cursor = location_##SUFFIX(head, tmp->key_prefix[KEY], tmp->FIELD);            \
+                                                                                                    \
+	if (KERNEL_AFTER(ORDER, key_compare(tmp->key_prefix[KEY], tmp->FIELD,                       \
+	                                    cursor->key_prefix[KEY], cursor->FIELD))){              \
+		/* belongs after the tail */                                                        \
+		tmp->previous = NULL;                                                               \
+		cursor->previous = tmp;                                                             \
+		tmp->next = cursor;                                                                 \
+	}else{                                                                                      \
+		/* or just ahead of the cursor */                                                   \
+		tmp->previous = cursor;                                                             \
+		tmp->next = cursor->next;                                                           \
+		if (cursor->next != NULL){                                                          \
+			cursor->next->previous = tmp;                                               \
+		}                                                                                   \
+		cursor->next = tmp;                                                                 \
+	}                                                                                           \
+}
+
+LIST_KERNELS(given_ascend, first_name, GIVEN, ASCEND)
+LIST_KERNELS(given_descend, first_name, GIVEN, DESCEND)
+LIST_KERNELS(family_ascend, last_name, FAMILY, ASCEND)
+LIST_KERNELS(family_descend, last_name, FAMILY, DESCEND)
+
+/*! \brief search kernels, indexed by [sort_key][sort_order == ASCEND] */
+struct node *(*const location_kernels[2][2])(struct node *, uint64_t, char *) = {
+	{location_given_descend, location_given_ascend},
+	{location_family_descend, location_family_ascend}
+};
+
+/*! \brief insertion kernels, indexed by [sort_key][sort_order == ASCEND] */
+void (*const insert_kernels[2][2])(struct node *, struct node *) = {
+	{insert_given_descend, insert_given_ascend},
+	{insert_family_descend, insert_family_ascend}
+};
+
+
+/*!
+ * \brief packs the first KEY_PREFIX_LENGTH bytes of a name into an integer, big endian and zero
+ * padded, so that comparing two prefixes as integers orders them exactly as strcmp would
+ *
+ * \param name - the name to pack
+ *
+ * \return the packed prefix
+ */
+uint64_t key_prefix(char *name){
+	uint64_t prefix = 0;
+
+	for (int i = 0; i < KEY_PREFIX_LENGTH; ++i){
+		prefix <<= 8;
+		if (*name != '\0'){
+			prefix |= (unsigned char)*name++;
+		}
+	}
+
+	return prefix;
+}
+
+/*!
+ * \brief compare two names through their prefixes, only falling back to strcmp when the prefixes
+ * tie
+ *
+ * \param prefix - key prefix of \a name
+ * \param name - first name to compare
+ * \param prefix2 - key prefix of \a name2
+ * \param name2 - second name to compare
+ *
+ * \return an integer less than, equal to, or greater than zero, as strcmp
+ */
+int key_compare(uint64_t prefix, char *name, uint64_t prefix2, char *name2){
+	if (prefix != prefix2){
+		return (prefix > prefix2) ? 1 : -1;
+	}
+
+	return strcmp(name, name2);
+}
+
+
+/*!
+ * remove the nth element from the list and return the pointer to the (possibly new) head
+ *
+ * \param head - the head of the list
+ * \param location - the location to remove
+ *
+ * \return pointer to the head node
+ */
+struct node* delete_nth(struct node *head, int location){
+	
+	if (head != NULL){
+
+	
+		struct node *cursor = head_pointer(head);
+		int i;
+
+		if (location >= 0){
+			for (i = 0; i < location; ++i){
+				if (cursor->previous != NULL){
+					cursor = cursor->previous;	
+				}
+			}
+		}
+	
+		/* remove the node */
+		if (cursor->next != NULL || cursor->previous != NULL){
+			/* if the length of the list is greater than 1, remove the node */
+			if (cursor->next != NULL) {
+				cursor->next->previous = cursor->previous;	
+			}else{
+				/* is the head, so we need to define a new head (its next is cleared below) */
+				head = cursor->previous;
+			}
+			if (cursor->previous != NULL){
+				cursor->previous->next = cursor->next;	
+			}else{
+				/* is the tail, and next exists */
+				cursor->next->previous = NULL;
+			}
+		} else{
+			/* otherwise it's just the head */
+			head = NULL;
+		}
+
+		free_node(cursor);
+	}
+
+	return head;
+}
+
+
+/*!
+ * \brief release a node, along with every string and array it owns. The node must already be
+ * unlinked from any list.
+ *
+ * \param n - the node to free
+ */
+void free_node(struct node *n){
+	if (n == NULL) return;
+
+	/* free up the names, unless they were short enough to live in the node */
+	if (n->first_name != n->inline_names[GIVEN]) free(n->first_name);
+	if (n->last_name != n->inline_names[FAMILY]) free(n->last_name);
+	/* don't forget to free up each of the assignment names */
+	if (n->assignments != NULL){
+		for (int i = 0; i < n->num_assignments; ++i){
+			free(n->assignments[i].name);
+		}
+	}
+	/* then the assignment list itself, if it has moved out of the node */
+	if (!node_assignments_inline(n)) free(n->assignments);
+	/* and finally the node itself */
+	free(n);
+}
+
+
+/*!
+ * \brief allocate and populate a node. The node, its short names and its assignment array all
+ * share a single allocation, so walking the list touches as few cache lines as possible.
+ *
+ * \param first_name - the given name to store in the node
+ * \param last_name - the family name to store in the node
+ * \param assignments - the list of assignments for the given student
+ * \param num_assignments - the length of the assignments list
+ * \param sort_key - which of the 2 names to use
+ * \param sort_order - the direction of the sort
+ *
+ * \return pointer to the new node, or NULL on allocation failure
+ */
+struct node *new_node(char *first_name, char *last_name, struct assignment *assignments,
+                      long int num_assignments, int sort_key, int sort_order){
+	struct node *n = (struct node *)malloc(sizeof(struct node) +
+	                                       num_assignments * sizeof(struct assignment));
+
+	if (n == NULL) return NULL;
+
+	/* the assignment array lives right after the node */
+	if (node_fill(n, first_name, last_name, assignments, num_assignments, sort_key, sort_order,
+	              (struct assignment *)(n + 1)) != 0){
+		free(n);
+		return NULL;
+	}
+	n->inline_assignments = num_assignments;
+
+	return n;
+}
+
+
+/*!
+ * \brief tells whether the assignment array of a node is still the one allocated with it
+ *
+ * \param n - the node in question
+ *
+ * \return 1 if the array trails the node, 0 if it has been moved to its own allocation
+ */
+int node_assignments_inline(struct node *n){
+	return n->assignments == (struct assignment *)(n + 1);
+}
+
+
+/*!
+ * \brief A funtion to add the value to a given list, with a specified sort order. The assignment
+ * array is allocated on its own, so the node may come from a plain malloc(sizeof(struct node)).
+ * \param n - pointer to the node in question
+ * \param last_name - the family name to store in the node
+ * \param first_name - the given name to store in the node
+ * \param assignments - the list of assignments for the given student
+ * \param num_assignments - the length of the assignments list
+ * \param sort_key - which of the 2 names to use
+ * \param sort_order - the direction of the sort
+ *                   1 for ascending
+ *                   -1 for descending
+ *
+ * \return 0, or -1 if memory ran out (the node then owns nothing but itself)
+ */
+int populate_node(struct node *n, char *first_name, char *last_name,
+                  struct assignment *assignments, long int num_assignments, 
+                  int sort_key, int sort_order){
+	struct assignment *storage = NULL;
+
+	if (n == NULL) return -1;
+
+	/* nothing was allocated with the node */
+	n->inline_assignments = 0;
+
+	if (num_assignments > 0){
+		storage = (struct assignment *)malloc(num_assignments * sizeof(struct assignment));
+		if (storage == NULL){
+			n->first_name = NULL;
+			n->last_name = NULL;
+			node_clear(n, sort_key, sort_order);
+			return -1;
+		}
+	}
+
+	if (node_fill(n, first_name, last_name, assignments, num_assignments, sort_key, sort_order, storage) != 0){
+		free(storage);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/*!
+ * \brief fills in a node, with its assignment array in the given storage (which new_node places
+ * right after the node, and populate_node on the heap)
+ *
+ * \param n - pointer to the node in question
+ * \param first_name - the given name to store in the node
+ * \param last_name - the family name to store in the node
+ * \param assignments - the list of assignments for the given student
+ * \param num_assignments - the length of the assignments list
+ * \param sort_key - which of the 2 names to use
+ * \param sort_order - the direction of the sort
+ * \param storage - room for num_assignments assignments
+ *
+ * \return 0, or -1 if memory ran out (the node then owns no memory, and has no assignments)
+ */
+int node_fill(struct node *n, char *first_name, char *last_name, struct assignment *assignments,
+              long int num_assignments, int sort_key, int sort_order, struct assignment *storage){
+	int first_name_length = min(strlen(first_name) + 1, MAX_STRING_LENGTH);
+	int last_name_length = min(strlen(last_name) + 1, MAX_STRING_LENGTH);
+	int assignment_name_length = 0;
+	long int i;
+
+	/* sets the first name, in the node if it fits and on the heap if not */
+	n->first_name = (first_name_length <= INLINE_NAME_LENGTH) ? n->inline_names[GIVEN]
+	                                                         : (char *)malloc(first_name_length);
+	/* do the same for last name */
+	n->last_name = (last_name_length <= INLINE_NAME_LENGTH) ? n->inline_names[FAMILY]
+	                                                       : (char *)malloc(last_name_length);
+	n->assignments = storage;
+	n->num_assignments = 0;
+	n->assignment_capacity = 0;
+	if (n->first_name == NULL || n->last_name == NULL){
+		node_clear(n, sort_key, sort_order);
+		return -1;
+	}
+
+	strncpy(n->first_name, first_name, first_name_length);
+	n->first_name[first_name_length - 1] = '\0';
+	strncpy(n->last_name, last_name, last_name_length);
+	n->last_name[last_name_length - 1] = '\0';
+	
+	/* store the sorting information, packing both names so a change of key needs no repacking */
+	n->sort_order = sort_order;
+	n->sort_key = sort_key;
+	n->key_prefix[GIVEN] = key_prefix(n->first_name);
+	n->key_prefix[FAMILY] = key_prefix(n->last_name);
+	
+	if (assignments != NULL){
+		for (i = 0; i < num_assignments; ++i){
+			/* determine the length of the assignment name */
+			assignment_name_length = min(strlen(assignments[i].name) + 1, MAX_STRING_LENGTH);
+			/* and allocate storage for it */
+			n->assignments[i].name = (char *)malloc(assignment_name_length);
+			if (n->assignments[i].name == NULL) break;
+			
+			/* then copy it into its proper place */
+			strncpy(n->assignments[i].name, assignments[i].name, assignment_name_length);
+			n->assignments[i].name[assignment_name_length - 1] = '\0';
+			
+			n->assignments[i].value = assignments[i].value;
+		} /* for */
+		if (i < num_assignments){
+			while (i-- > 0){
+				free(n->assignments[i].name);
+			}
+			node_clear(n, sort_key, sort_order);
+			return -1;
+		}
+	} /* if (assignments != NULL) */
+	
+	/* store the assignment count */
+	n->num_assignments = num_assignments;
+	n->assignment_capacity = num_assignments;
+	
+	/* we don't know where these should point yet, so just NULL them out */
+	n->next = NULL;
+	n->previous = NULL;
+	
+	return 0;
+}
+
+
+/*!
+ * \brief gives back the names of a node that could not be filled in, and leaves it empty, with no
+ * assignments, so that free_node can still be used on it
+ *
+ * \param n - the node
+ * \param sort_key - which of the 2 names to use
+ * \param sort_order - the direction of the sort
+ */
+void node_clear(struct node *n, int sort_key, int sort_order){
+	if (n->first_name != n->inline_names[GIVEN]) free(n->first_name);
+	if (n->last_name != n->inline_names[FAMILY]) free(n->last_name);
+	n->first_name = n->inline_names[GIVEN];
+	n->last_name = n->inline_names[FAMILY];
+	n->first_name[0] = '\0';
+	n->last_name[0] = '\0';
+	n->key_prefix[GIVEN] = 0;
+	n->key_prefix[FAMILY] = 0;
+	n->sort_order = sort_order;
+	n->sort_key = sort_key;
+	n->assignments = NULL;
+	n->num_assignments = 0;
+	n->assignment_capacity = 0;
+	n->next = NULL;
+	n->previous = NULL;
+}
+
+
+/*!
+ * \brief sorts the whole list on a name, whatever order it is currently in. The nodes are sorted in
+ * place with a multikey (radix) quicksort on the characters of the name, and then relinked, so no
+ * node or string is copied.
+ *
+ * \param head - the head of the list
+ * \param sort_key - whether to sort on first or last name; SCORE is handed to sort_list_by_score,
+ *                   and ASSIGNMENT_SCORE leaves the list as it is
+ * \param sort_order - whether to sort ascending or descending
+ *
+ * \return pointer to the head node
+ */
+struct node *bulk_sort_list(struct node *head, int sort_key, int sort_order){
+	struct node *cursor = head_pointer(head);
+	long int length = list_length(cursor);
+	struct sort_entry *entries;
+	struct node **nodes;
+
+	if (length == 0) return NULL;
+
+	/* there are no names to sort a score on, and no assignment to rank on */
+	if (sort_key == SCORE) return sort_list_by_score(cursor, NULL, sort_order);
+	if (sort_key == ASSIGNMENT_SCORE) return cursor;
+
+	entries = (struct sort_entry *)malloc(length * sizeof(struct sort_entry));
+	nodes = (struct node **)malloc(length * sizeof(struct node *));
+	if (entries == NULL || nodes == NULL){
+		free(entries);
+		free(nodes);
+		return cursor;
+	}
+
+	for (long int i = 0; i < length; ++i, cursor = cursor->previous){
+		entries[i].prefix = cursor->key_prefix[sort_key];
+		entries[i].node = cursor;
+	}
+
+	name_sort(entries, length, sort_key, 0);
+
+	for (long int i = 0; i < length; ++i){
+		nodes[i] = entries[i].node;
+	}
+	head = relink(nodes, length, sort_key, sort_order);
+
+	free(entries);
+	free(nodes);
+
+	return head;
+}
+
+
+/*!
+ * \brief multikey quicksort of nodes on a name: three way partition on the character at \a depth,
+ * then recurse on the smaller and larger parts at the same depth, and on the equal part one
+ * character deeper. Small parts are finished off with an insertion sort.
+ *
+ * \param entries - array of nodes to sort, all sharing their first \a depth characters
+ * \param length - how many nodes there are
+ * \param sort_key - whether to sort on first or last name
+ * \param depth - number of leading characters already known to be equal
+ */
+void name_sort(struct sort_entry *entries, long int length, int sort_key, int depth){
+	struct sort_entry swap;
+	long int lt, gt, i;
+	int a, b, c, pivot;
+
+	while (length > 1){
+		if (length < NAME_SORT_CUTOFF){
+			for (i = 1; i < length; ++i){
+				for (long int j = i; j > 0; --j){
+					struct node *n = entries[j].node;
+					struct node *n2 = entries[j - 1].node;
+					char *names[] = {n->first_name, n->last_name};
+					char *names2[] = {n2->first_name, n2->last_name};
+
+					if (key_compare(entries[j].prefix, names[sort_key],
+					                entries[j - 1].prefix, names2[sort_key]) >= 0){
+						break;
+					}
+					swap = entries[j];
+					entries[j] = entries[j - 1];
+					entries[j - 1] = swap;
+				}
+			}
+			return;
+		}
+
+		/* median of three for the pivot character */
+		a = name_char(&entries[0], sort_key, depth);
+		b = name_char(&entries[length / 2], sort_key, depth);
+		c = name_char(&entries[length - 1], sort_key, depth);
+		pivot = max(min(a, b), min(max(a, b), c));
+
+		/* entries[0, lt) < pivot, entries[lt, i) == pivot, entries(gt, length) > pivot */
+		lt = 0;
+		i = 0;
+		gt = length - 1;
+		while (i <= gt){
+			c = name_char(&entries[i], sort_key, depth);
+			if (c < pivot){
+				swap = entries[lt];
+				entries[lt++] = entries[i];
+				entries[i++] = swap;
+			}else if (c > pivot){
+				swap = entries[gt];
+				entries[gt--] = entries[i];
+				entries[i] = swap;
+			}else{
+				++i;
+			}
+		}
+
+		name_sort(entries, lt, sort_key, depth);
+
+		/* a zero pivot means the equal names have all ended here, so they are done */
+		if (pivot != 0){
+			name_sort(entries + lt, gt - lt + 1, sort_key, depth + 1);
+		}
+
+		/* loop on the larger characters, rather than recursing */
+		entries += gt + 1;
+		length -= gt + 1;
+	}
+}
+
+
+/*!
+ * \brief the character of a name at a given depth. The leading characters come out of the packed
+ * key prefix, so the node itself is only touched past KEY_PREFIX_LENGTH.
+ *
+ * \param e - the entry in question
+ * \param sort_key - whether to look at first or last name
+ * \param depth - index of the character (all characters before it must be non zero)
+ *
+ * \return the character, as an unsigned value, or 0 past the end of the name
+ */
+int name_char(struct sort_entry *e, int sort_key, int depth){
+	char *names[2];
+
+	if (depth < KEY_PREFIX_LENGTH){
+		return (int)((e->prefix >> (8 * (KEY_PREFIX_LENGTH - 1 - depth))) & 0xff);
+	}
+
+	names[GIVEN] = e->node->first_name;
+	names[FAMILY] = e->node->last_name;
+
+	return (unsigned char)names[sort_key][depth];
+}
+
+
+/*!
+ * \brief links an ascending array of nodes up into a list with the given sort order
+ *
+ * \param nodes - array of nodes, in ascending order
+ * \param length - how many nodes there are
+ * \param sort_key - the sort key to store in every node
+ * \param sort_order - the sort order to store in every node, and to link in
+ *
+ * \return pointer to the head node
+ */
+struct node *relink(struct node **nodes, long int length, int sort_key, int sort_order){
+	struct node *swap;
+
+	if (length == 0) return NULL;
+
+	if (sort_order == DESCEND){
+		for (long int i = 0; i < length / 2; ++i){
+			swap = nodes[i];
+			nodes[i] = nodes[length - 1 - i];
+			nodes[length - 1 - i] = swap;
+		}
+	}
+
+	for (long int i = 0; i < length; ++i){
+		nodes[i]->next = (i > 0) ? nodes[i - 1] : NULL;
+		nodes[i]->previous = (i < length - 1) ? nodes[i + 1] : NULL;
+		nodes[i]->sort_key = sort_key;
+		nodes[i]->sort_order = sort_order;
+	}
+
+	return nodes[0];
+}
+
+
+/*!
+ * \brief builds an ordered index over a list, for seeking by name in O(log n). The index holds
+ * pointers only, and is out of date as soon as the list is changed.
+ *
+ * \param head - the head of the list
+ *
+ * \return pointer to the new index, or NULL if the list is empty, sorted on a score, or memory runs out
+ */
+struct list_index *list_index_build(struct node *head){
+	struct node *cursor = head_pointer(head);
+	struct list_index *index;
+	long int length = list_length(cursor);
+
+	if (length == 0 || cursor->sort_key >= SCORE) return NULL;
+
+	index = (struct list_index *)malloc(sizeof(struct list_index));
+	if (index == NULL) return NULL;
+
+	index->nodes = (struct node **)malloc(length * sizeof(struct node *));
+	if (index->nodes == NULL){
+		free(index);
+		return NULL;
+	}
+	index->length = length;
+	index->sort_key = cursor->sort_key;
+	index->sort_order = cursor->sort_order;
+
+	/* the index is always ascending, whatever the direction of the list */
+	for (long int i = 0; i < length; ++i, cursor = cursor->previous){
+		index->nodes[(index->sort_order == ASCEND) ? i : length - 1 - i] = cursor;
+	}
+
+	return index;
+}
+
+
+/*!
+ * \brief releases an index (the list is untouched)
+ *
+ * \param index - the index to free
+ */
+void list_index_free(struct list_index *index){
+	if (index == NULL) return;
+
+	free(index->nodes);
+	free(index);
+}
+
+
+/*!
+ * \brief binary search for the first student whose sort name is at least \a name, or (with a
+ * non zero \a prefix_length) whose first \a prefix_length characters are greater than \a name's
+ *
+ * \param index - the index to search
+ * \param name - the name to seek to
+ * \param prefix_length - 0 to compare whole names, or the number of leading characters to compare
+ *
+ * \return position in the index, index->length if every name is smaller
+ */
+long int index_seek(struct list_index *index, char *name, size_t prefix_length){
+	uint64_t prefix = key_prefix(name);
+	long int low = 0;
+	long int high = index->length;
+	long int middle;
+
+	while (low < high){
+		struct node *n;
+		int comp;
+
+		middle = low + (high - low) / 2;
+		n = index->nodes[middle];
+
+		if (prefix_length == 0){
+			char *names[] = {n->first_name, n->last_name};
+			comp = key_compare(n->key_prefix[index->sort_key], names[index->sort_key], prefix, name) >= 0;
+		}else{
+			char *names[] = {n->first_name, n->last_name};
+			comp = strncmp(names[index->sort_key], name, prefix_length) > 0;
+		}
+
+		if (comp){
+			high = middle;
+		}else{
+			low = middle + 1;
+		}
+	}
+
+	return low;
+}
+
+
+/*!
+ * \brief a cursor over every student whose sort name lies in [\a low, \a high), in the order of the
+ * list the index was built from
+ *
+ * \param index - the index to search
+ * \param low - smallest name included, or NULL to start at the first name
+ * \param high - first name excluded, or NULL to run to the last name
+ *
+ * \return the cursor
+ */
+struct list_cursor cursor_range(struct list_index *index, char *low, char *high){
+	struct list_cursor cursor;
+
+	cursor.index = index;
+	cursor.start = (low == NULL) ? 0 : index_seek(index, low, 0);
+	cursor.end = (high == NULL) ? index->length : index_seek(index, high, 0);
+	cursor.end = max(cursor.start, cursor.end);
+	cursor.position = (index->sort_order == ASCEND) ? cursor.start : cursor.end;
+
+	return cursor;
+}
+
+
+/*!
+ * \brief a cursor over every student whose sort name starts with \a prefix, in the order of the list
+ * the index was built from
+ *
+ * \param index - the index to search
+ * \param prefix - the leading characters to match, e.g. "Mc"
+ *
+ * \return the cursor
+ */
+struct list_cursor cursor_prefix(struct list_index *index, char *prefix){
+	struct list_cursor cursor = cursor_range(index, prefix, NULL);
+
+	/* everything from the prefix on, up to the first name that no longer starts with it */
+	if (prefix[0] != '\0'){
+		cursor.end = index_seek(index, prefix, strlen(prefix));
+		cursor.position = (index->sort_order == ASCEND) ? cursor.start : cursor.end;
+	}
+
+	return cursor;
+}
+
+
+/*!
+ * \brief steps a cursor on to its next student
+ *
+ * \param cursor - the cursor to step
+ *
+ * \return the next node in the range (not a copy), or NULL when the range is done
+ */
+struct node *cursor_next(struct list_cursor *cursor){
+	if (cursor->index->sort_order == ASCEND){
+		return (cursor->position < cursor->end) ? cursor->index->nodes[cursor->position++] : NULL;
+	}
+
+	return (cursor->position > cursor->start) ? cursor->index->nodes[--cursor->position] : NULL;
+}
+
+
+/*!
+ * \brief walks the list and adds up the memory it holds, by what the memory is used for. Names
+ * and assignment arrays that live inside their node's allocation are counted in their own
+ * category but add no allocation of their own. Slots allocated with a node stay counted after its
+ * array has moved out, and arrays are counted at their capacity, since that is what is held.
+ *
+ * \param head - pointer to the list
+ *
+ * \return the memory usage, all zero for an empty list
+ */
+struct memory_usage list_memory_usage(struct node *head){
+	struct memory_usage usage = {0, 0, 0, 0, 0, 0, 0, 0};
+	size_t inline_size;
+	size_t array_size;
+	char *names[2];
+
+	for (struct node *cursor = head_pointer(head); cursor != NULL; cursor = cursor->previous){
+		++usage.nodes;
+
+		/* the node, with the assignment slots allocated along with it, used or not */
+		inline_size = cursor->inline_assignments * sizeof(struct assignment);
+		usage.node_bytes += sizeof(struct node);
+		usage.assignment_array_bytes += inline_size;
+		memory_account(&usage, sizeof(struct node) + inline_size);
+
+		/* and the array it has moved to, if it has (a node with no array has no allocation) */
+		if (cursor->assignments != NULL && !node_assignments_inline(cursor)){
+			array_size = cursor->assignment_capacity * sizeof(struct assignment);
+			usage.assignment_array_bytes += array_size;
+			memory_account(&usage, array_size);
+		}
+
+		/* names, only the long ones have an allocation */
+		names[GIVEN] = cursor->first_name;
+		names[FAMILY] = cursor->last_name;
+		for (int k = 0; k < 2; ++k){
+			if (names[k] != cursor->inline_names[k]){
+				usage.name_bytes += strlen(names[k]) + 1;
+				memory_account(&usage, strlen(names[k]) + 1);
+			}
+		}
+
+		for (long int i = 0; i < cursor->num_assignments; ++i){
+			usage.assignment_name_bytes += strlen(cursor->assignments[i].name) + 1;
+			memory_account(&usage, strlen(cursor->assignments[i].name) + 1);
+		}
+	}
+
+	usage.total_bytes = usage.node_bytes + usage.name_bytes + usage.assignment_array_bytes +
+	                    usage.assignment_name_bytes + usage.overhead_bytes;
+
+	return usage;
+}
+
+
+/*!
+ * \brief counts one allocation of the given size, and the allocator overhead that comes with it
+ *
+ * \param usage - the running totals
+ * \param bytes - the size that was asked of malloc
+ */
+void memory_account(struct memory_usage *usage, size_t bytes){
+	++usage->allocations;
+	usage->overhead_bytes += malloc_chunk_size(bytes) - bytes;
+}
+
+
+/*!
+ * \brief estimates how much heap a malloc of the given size really takes, assuming the layout of
+ * glibc on 64 bit targets: a size word of header, rounded up to 16 bytes, with a 32 byte minimum
+ *
+ * \param bytes - the size asked for
+ *
+ * \return the estimated size of the chunk
+ */
+size_t malloc_chunk_size(size_t bytes){
+	size_t chunk = (bytes + MALLOC_HEADER + MALLOC_ALIGNMENT - 1) & ~(size_t)(MALLOC_ALIGNMENT - 1);
+
+	return max(chunk, MALLOC_MINIMUM_CHUNK);
+}
+
+
+/*!
+ * \brief prints a memory usage report
+ *
+ * \param stream - where to print it
+ * \param usage - the usage to report
+ */
+void print_memory_usage(FILE *stream, struct memory_usage *usage){
+	fprintf(stream, "nodes:              %10ld\n", usage->nodes);
+	fprintf(stream, "node bytes:         %10zu\n", usage->node_bytes);
+	fprintf(stream, "name bytes:         %10zu\n", usage->name_bytes);
+	fprintf(stream, "assignment arrays:  %10zu\n", usage->assignment_array_bytes);
+	fprintf(stream, "assignment names:   %10zu\n", usage->assignment_name_bytes);
+	fprintf(stream, "allocations:        %10ld\n", usage->allocations);
+	fprintf(stream, "allocator overhead: %10zu\n", usage->overhead_bytes);
+	fprintf(stream, "total bytes:        %10zu\n", usage->total_bytes);
+}
+
+
+/*!
+ * \brief merges several lists, each already sorted the same way, into one sorted list in
+ * O(N log k) with a heap over the heads of the k lists. The nodes are spliced, not copied. A list
+ * sorted another way is sorted first. Students with equal keys keep the order of their lists.
+ *
+ * \param lists - the lists to merge; they are used up, and set to NULL
+ * \param num_lists - how many lists there are
+ * \param sort_key - whether the lists are sorted on first or last name
+ * \param sort_order - whether the lists are sorted ascending or descending
+ * \param combine - if non zero, a student found in more than one list is kept once, with the
+ *                  assignments of both (the later list's score wins on a clash). Duplicates are
+ *                  found through a student table over the merged list, so this stays O(1) a node
+ *                  however many students share a name.
+ *
+ * \return pointer to the head node of the merged list, or NULL if sort_key is not a name or memory
+ *         runs out (the lists are then left as they were)
+ */
+struct node *merge_lists(struct node **lists, int num_lists, int sort_key, int sort_order, int combine){
+	struct merge_source *heap;
+	struct student_table *seen = NULL;
+	struct node *head = NULL;
+	struct node *tail = NULL;
+	struct node *same;
+	struct node *n;
+	long int total = 0;
+	int size = 0;
+
+	/* the heap compares names, so there is nothing to merge a score on */
+	if (sort_key >= SCORE) return NULL;
+
+	heap = (struct merge_source *)malloc(max(num_lists, 1) * sizeof(struct merge_source));
+	if (heap == NULL) return NULL;
+
+	if (combine){
+		/* sized for every student up front, so adding to it never has to grow it, or fail */
+		for (int i = 0; i < num_lists; ++i){
+			total += list_length(head_pointer(lists[i]));
+		}
+		seen = student_table_new(total);
+		if (seen == NULL){
+			free(heap);
+			return NULL;
+		}
+	}
+
+	for (int i = 0; i < num_lists; ++i){
+		if (lists[i] == NULL) continue;
+		lists[i] = head_pointer(lists[i]);
+		if (lists[i]->sort_key != sort_key || lists[i]->sort_order != sort_order){
+			lists[i] = sort_list(lists[i], sort_key, sort_order);
+		}
+		heap[size].node = lists[i];
+		heap[size].list = i;
+		++size;
+		lists[i] = NULL;
+	}
+
+	for (int i = size / 2 - 1; i >= 0; --i){
+		merge_sift(heap, size, i, sort_key, sort_order);
+	}
+
+	while (size > 0){
+		/* take the first of the heads, and move its list along */
+		n = heap[0].node;
+		heap[0].node = n->previous;
+		if (heap[0].node == NULL){
+			heap[0] = heap[--size];
+		}
+		merge_sift(heap, size, 0, sort_key, sort_order);
+
+		/* has the same student been merged already? */
+		if (combine){
+			same = student_table_find(seen, n->first_name, n->last_name);
+			if (same != NULL){
+				combine_students(same, n);
+				continue;
+			}
+			student_table_add(seen, n);
+		}
+
+		/* splice the node onto the tail of the merged list */
+		n->sort_key = sort_key;
+		n->sort_order = sort_order;
+		n->next = tail;
+		n->previous = NULL;
+		if (tail != NULL){
+			tail->previous = n;
+		}else{
+			head = n;
+		}
+		tail = n;
+	}
+
+	student_table_free(seen);
+	free(heap);
+
+	return head;
+}
+
+
+/*!
+ * \brief loads several gradebook files, each sorted the same way, and merges them with
+ * merge_lists. Each file is chained in the order it is read, and only sorted if it turns out not
+ * to be in order, so sorted inputs are loaded in O(N).
+ *
+ * \param streams - the files to read
+ * \param num_streams - how many files there are
+ * \param sort_key - whether to sort on first or last name
+ * \param sort_order - whether to sort ascending or descending
+ * \param combine - if non zero, combine students found in more than one file
+ *
+ * \return pointer to the head node of the merged list, or NULL if sort_key is not a name (nothing
+ *         is read then) or memory runs out
+ */
+struct node *merge_files(FILE **streams, int num_streams, int sort_key, int sort_order, int combine){
+	struct node **lists;
+	struct node *head;
+
+	if (sort_key >= SCORE) return NULL;
+
+	lists = (struct node **)malloc(max(num_streams, 1) * sizeof(struct node *));
+	if (lists == NULL) return NULL;
+
+	for (int i = 0; i < num_streams; ++i){
+		lists[i] = chain_from_file(NULL, streams[i], sort_key, sort_order);
+		if (!list_in_order(lists[i], sort_key, sort_order)){
+			lists[i] = bulk_sort_list(lists[i], sort_key, sort_order);
+		}
+	}
+	head = merge_lists(lists, num_streams, sort_key, sort_order, combine);
+
+	/* merge_lists only leaves lists behind when it ran out of memory */
+	for (int i = 0; i < num_streams; ++i){
+		delete_list(lists[i]);
+	}
+	free(lists);
+
+	return head;
+}
+
+
+/*!
+ * \brief checks that a list is in the given order, walking it once
+ *
+ * \param head - the head of the list (possibly NULL)
+ * \param sort_key - whether to check first or last names, or SCORE for mean scores
+ * \param sort_order - whether they should be ascending or descending
+ *
+ * \return 1 if every node is in order with the next, 0 otherwise
+ */
+int list_in_order(struct node *head, int sort_key, int sort_order){
+	struct node *cursor = head_pointer(head);
+
+	for (; cursor != NULL && cursor->previous != NULL; cursor = cursor->previous){
+		struct node *after = cursor->previous;
+		char *names[] = {cursor->first_name, cursor->last_name};
+		char *after_names[] = {after->first_name, after->last_name};
+
+		if (sort_key >= SCORE){
+			if ((sort_order == ASCEND) ? node_score(cursor, NULL) > node_score(after, NULL)
+			                           : node_score(cursor, NULL) < node_score(after, NULL)){
+				return 0;
+			}
+		}else if (key_compare(cursor->key_prefix[sort_key], names[sort_key], after->key_prefix[sort_key],
+		                after_names[sort_key]) * sort_order > 0){
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+
+/*!
+ * \brief restores the heap property of the merge heap below the given slot
+ *
+ * \param heap - the heap of list heads
+ * \param size - number of entries in the heap
+ * \param i - the slot whose entry may be out of place
+ * \param sort_key - the name the lists are sorted on
+ * \param sort_order - the direction they are sorted in
+ */
+void merge_sift(struct merge_source *heap, int size, int i, int sort_key, int sort_order){
+	struct merge_source moving = heap[i];
+	int child;
+
+	while ((child = 2 * i + 1) < size){
+		if (child + 1 < size && merge_compare(&heap[child + 1], &heap[child], sort_key, sort_order) < 0){
+			++child;
+		}
+		if (merge_compare(&heap[child], &moving, sort_key, sort_order) >= 0) break;
+		heap[i] = heap[child];
+		i = child;
+	}
+	heap[i] = moving;
+}
+
+
+/*!
+ * \brief orders two list heads in the merge heap, by name and then by list
+ *
+ * \param a - the first head
+ * \param b - the second head
+ * \param sort_key - the name the lists are sorted on
+ * \param sort_order - the direction they are sorted in
+ *
+ * \return negative if a comes first, positive if b does
+ */
+int merge_compare(struct merge_source *a, struct merge_source *b, int sort_key, int sort_order){
+	char *a_names[] = {a->node->first_name, a->node->last_name};
+	char *b_names[] = {b->node->first_name, b->node->last_name};
+	int result = key_compare(a->node->key_prefix[sort_key], a_names[sort_key], b->node->key_prefix[sort_key],
+	                         b_names[sort_key]) * sort_order;
+
+	return (result != 0) ? result : a->list - b->list;
+}
+
+
+/*!
+ * \brief folds the assignments of a duplicate student into another node, and frees the duplicate.
+ * Scores for assignments both have are taken from the duplicate.
+ *
+ * \param keep - the node that stays
+ * \param extra - the unlinked duplicate, freed here
+ */
+void combine_students(struct node *keep, struct node *extra){
+	merge_scores(keep, extra->assignments, extra->num_assignments);
+
+	free_node(extra);
+}
+
+
+/*!
+ * \brief computes the weighted total of every student of a score table in one pass over the
+ * packed columns. A missing grade counts as 0. Rows are taken in blocks of FINAL_GRADE_BLOCK, so
+ * the totals being summed stay in cache while every weighted column is added to them.
+ *
+ * \param t - the score table
+ * \param assignments - names of the weighted assignments
+ * \param weights - the weight of each of them
+ * \param num_weights - how many weights there are
+ * \param grades - output, one total per row of the table, in list order
+ *
+ * \return 0, or -1 if an assignment is not in the table (grades is then left untouched)
+ */
+int final_grades(struct score_table *t, char **assignments, double *weights, long int num_weights,
+                 double *grades){
+	long int *columns = (long int *)malloc(max(num_weights, 1) * sizeof(long int));
+	long int length;
+
+	if (columns == NULL) return -1;
+
+	for (long int w = 0; w < num_weights; ++w){
+		columns[w] = packed_column_index(t, assignments[w]);
+		if (columns[w] < 0){
+			free(columns);
+			return -1;
+		}
+	}
+
+	for (long int start = 0; start < t->rows; start += FINAL_GRADE_BLOCK){
+		length = min(FINAL_GRADE_BLOCK, t->rows - start);
+		memset(grades + start, 0, length * sizeof(double));
+		for (long int w = 0; w < num_weights; ++w){
+			struct packed_column *column = &t->columns[columns[w]];
+
+			/* fold the fixed point scale into the weight */
+			packed_axpy(grades + start, column->scores + start, length, weights[w] / column->scale);
+		}
+	}
+
+	free(columns);
+
+	return 0;
+}
+
+
+/*!
+ * \brief adds weight times each packed score to the totals, treating missing grades as 0. The
+ * loop is branch free and its pointers don't alias, so the compiler turns it into SIMD code.
+ *
+ * \param totals - the running totals
+ * \param scores - the packed scores
+ * \param length - number of rows
+ * \param weight - weight per code (the assignment weight over the column scale)
+ */
+void packed_axpy(double * restrict totals, const uint16_t * restrict scores, long int length, double weight){
+	long int i = 0;
+
+	/* fixed size groups, which the compiler vectorizes even at -O2; multiplying by 0 or 1 rather
+	 * than branching on missing grades keeps them straight line code */
+	for (; i + PACKED_LANES <= length; i += PACKED_LANES){
+		for (int j = 0; j < PACKED_LANES; ++j){
+			totals[i + j] += (double)(scores[i + j] != PACKED_MISSING) * scores[i + j] * weight;
+		}
+	}
+	for (; i < length; ++i){
+		totals[i] += (double)(scores[i] != PACKED_MISSING) * scores[i] * weight;
+	}
+}
+
+
+/*!
+ * \brief convenience wrapper around final_grades for a list, packing it into a score table first
+ *
+ * \param head - pointer to the list
+ * \param assignments - names of the weighted assignments
+ * \param weights - the weight of each of them
+ * \param num_weights - how many weights there are
+ *
+ * \return array of list_length(head) totals in list order, to be freed by the caller, or NULL if
+ *         the list is empty or an assignment is not in it
+ */
+double *list_final_grades(struct node *head, char **assignments, double *weights, long int num_weights){
+	struct score_table *t = score_table_from_list(head);
+	double *grades;
+
+	if (t == NULL) return NULL;
+
+	grades = (double *)malloc(t->rows * sizeof(double));
+	if (grades != NULL && final_grades(t, assignments, weights, num_weights, grades) != 0){
+		free(grades);
+		grades = NULL;
+	}
+
+	score_table_free(t);
+
+	return grades;
+}
+
+
+/*!
+ * \brief sorts the list on a score, either one assignment or the mean of all of them. Students
+ * missing the assignment rank below every score. The sort is stable, so students with equal
+ * scores keep their current order (sort on a name first to break ties by name). The nodes are
+ * marked with the SCORE sort key for the mean, or ASSIGNMENT_SCORE for one assignment, so the
+ * next name insert sorts the list back on names, and the next sort on the mean is not skipped.
+ *
+ * \param head - the head of the list
+ * \param assignment - name of the assignment to sort on, or NULL for the mean score
+ * \param sort_order - whether to sort ascending or descending
+ *
+ * \return pointer to the head node
+ */
+struct node *sort_list_by_score(struct node *head, char *assignment, int sort_order){
+	struct node *cursor = head_pointer(head);
+	long int length = list_length(cursor);
+	struct score_entry *entries;
+	struct score_entry *scratch;
+	struct node **nodes;
+
+	if (length == 0) return NULL;
+
+	entries = (struct score_entry *)malloc(length * sizeof(struct score_entry));
+	scratch = (struct score_entry *)malloc(length * sizeof(struct score_entry));
+	nodes = (struct node **)malloc(length * sizeof(struct node *));
+	if (entries == NULL || scratch == NULL || nodes == NULL){
+		free(entries);
+		free(scratch);
+		free(nodes);
+		return cursor;
+	}
+
+	/* a descending list is linked from the tail up, so take it in reverse to stay stable */
+	for (long int i = 0; i < length; ++i, cursor = cursor->previous){
+		long int slot = (sort_order == DESCEND) ? length - 1 - i : i;
+
+		entries[slot].score = node_score(cursor, assignment);
+		entries[slot].node = cursor;
+	}
+
+	score_merge_sort(entries, scratch, length);
+	for (long int i = 0; i < length; ++i){
+		nodes[i] = entries[i].node;
+	}
+	head = relink(nodes, length, (assignment == NULL) ? SCORE : ASSIGNMENT_SCORE, sort_order);
+
+	free(entries);
+	free(scratch);
+	free(nodes);
+
+	return head;
+}
+
+
+/*!
+ * \brief links a node into a list sorted on the mean score, after any students with the same
+ * score, so the list stays as sort_list_by_score would leave it. Takes a walk of the list.
+ *
+ * \param head - the head of the list (possibly NULL), marked with the SCORE sort key
+ * \param tmp - the unlinked node
+ *
+ * \return pointer to the head node
+ */
+struct node *insert_by_score(struct node *head, struct node *tmp){
+	struct node *cursor = head_pointer(head);
+	struct node *lag = NULL;
+	double score = node_score(tmp, NULL);
+
+	if (cursor == NULL) return tmp;
+
+	/* move past every student who ranks ahead of, or level with, the new one */
+	while (cursor != NULL && ((tmp->sort_order == ASCEND) ? node_score(cursor, NULL) <= score
+	                                                      : node_score(cursor, NULL) >= score)){
+		lag = cursor;
+		cursor = cursor->previous;
+	}
+
+	/* link in between lag and cursor */
+	tmp->next = lag;
+	tmp->previous = cursor;
+	if (lag != NULL) lag->previous = tmp;
+	if (cursor != NULL) cursor->next = tmp;
+
+	return (lag == NULL) ? tmp : head_pointer(lag);
+}
+
+
+/*!
+ * \brief the score a student is ranked on
+ *
+ * \param n - the student
+ * \param assignment - name of the assignment, or NULL for the mean of all of them
+ *
+ * \return the score, or -HUGE_VAL if the student has no such score
+ */
+double node_score(struct node *n, char *assignment){
+	double total = 0.0;
+	long int a;
+
+	if (assignment != NULL){
+		a = assignment_index(n, assignment);
+		return (a >= 0) ? n->assignments[a].value : -HUGE_VAL;
+	}
+
+	if (n->num_assignments == 0) return -HUGE_VAL;
+	for (long int i = 0; i < n->num_assignments; ++i){
+		total += n->assignments[i].value;
+	}
+
+	return total / n->num_assignments;
+}
+
+
+/*!
+ * \brief stable merge sort of score entries into ascending order of score
+ *
+ * \param entries - the entries to sort
+ * \param scratch - space for as many entries
+ * \param length - how many entries there are
+ */
+void score_merge_sort(struct score_entry *entries, struct score_entry *scratch, long int length){
+	long int half = length / 2;
+	long int i, j, k;
+
+	if (length < 2) return;
+
+	score_merge_sort(entries, scratch, half);
+	score_merge_sort(entries + half, scratch, length - half);
+
+	/* already in order, which is common when re-sorting */
+	if (entries[half - 1].score <= entries[half].score) return;
+
+	memcpy(scratch, entries, length * sizeof(struct score_entry));
+	for (i = 0, j = half, k = 0; i < half && j < length; ++k){
+		entries[k] = (scratch[j].score < scratch[i].score) ? scratch[j++] : scratch[i++];
+	}
+	while (i < half) entries[k++] = scratch[i++];
+	while (j < length) entries[k++] = scratch[j++];
+}
+
+
+/*!
+ * \brief builds a score ordered index over a list, for leaderboards. Unlike a list_index it can be
+ * kept current as students come and go, with indexed_insert and indexed_delete_nth, or with
+ * score_index_update after a score changes.
+ *
+ * \param head - the head of the list
+ * \param assignment - name of the assignment to rank on, or NULL for the mean score
+ *
+ * \return pointer to the new index, or NULL if memory runs out
+ */
+struct score_index *score_index_build(struct node *head, char *assignment){
+	struct score_index *index = (struct score_index *)malloc(sizeof(struct score_index));
+	struct node *cursor = head_pointer(head);
+	struct score_entry *scratch;
+	int name_length;
+
+	if (index == NULL) return NULL;
+
+	index->length = list_length(cursor);
+	index->capacity = max(index->length, 16);
+	index->entries = (struct score_entry *)malloc(index->capacity * sizeof(struct score_entry));
+	scratch = (struct score_entry *)malloc(index->capacity * sizeof(struct score_entry));
+	index->assignment = NULL;
+	if (assignment != NULL){
+		name_length = min(strlen(assignment) + 1, MAX_STRING_LENGTH);
+		index->assignment = (char *)malloc(name_length);
+		if (index->assignment != NULL){
+			strncpy(index->assignment, assignment, name_length);
+			index->assignment[name_length - 1] = '\0';
+		}
+	}
+	if (index->entries == NULL || scratch == NULL || (assignment != NULL && index->assignment == NULL)){
+		free(scratch);
+		score_index_free(index);
+		return NULL;
+	}
+
+	for (long int i = 0; i < index->length; ++i, cursor = cursor->previous){
+		index->entries[i].score = node_score(cursor, index->assignment);
+		index->entries[i].node = cursor;
+	}
+	score_merge_sort(index->entries, scratch, index->length);
+
+	free(scratch);
+
+	return index;
+}
+
+
+/*!
+ * \brief releases a score index, but not the list it is over
+ *
+ * \param index - the index to free
+ */
+void score_index_free(struct score_index *index){
+	if (index == NULL) return;
+
+	free(index->entries);
+	free(index->assignment);
+	free(index);
+}
+
+
+/*!
+ * \brief binary search of a score index
+ *
+ * \param index - the index to search
+ * \param score - the score to look for
+ * \param after - 0 for the first entry not below the score, 1 for the first entry above it
+ *
+ * \return the position found, from 0 to index->length
+ */
+long int score_index_seek(struct score_index *index, double score, int after){
+	long int low = 0;
+	long int high = index->length;
+	long int middle;
+
+	while (low < high){
+		middle = low + (high - low) / 2;
+		if (index->entries[middle].score < score || (after && index->entries[middle].score == score)){
+			low = middle + 1;
+		}else{
+			high = middle;
+		}
+	}
+
+	return low;
+}
+
+
+/*!
+ * \brief adds a student to a score index, after any students with the same score
+ *
+ * \param index - the index
+ * \param n - the student to add
+ *
+ * \return 0, or -1 if memory ran out
+ */
+int score_index_add(struct score_index *index, struct node *n){
+	struct score_entry *grown;
+	double score = node_score(n, index->assignment);
+	long int position;
+
+	if (index->length == index->capacity){
+		grown = (struct score_entry *)realloc(index->entries, 2 * index->capacity * sizeof(struct score_entry));
+		if (grown == NULL) return -1;
+		index->entries = grown;
+		index->capacity *= 2;
+	}
+
+	position = score_index_seek(index, score, 1);
+	memmove(index->entries + position + 1, index->entries + position,
+	        (index->length - position) * sizeof(struct score_entry));
+	index->entries[position].score = score;
+	index->entries[position].node = n;
+	++index->length;
+
+	return 0;
+}
+
+
+/*!
+ * \brief removes a student from a score index. The student is looked for under their current
+ * score first, and then everywhere, in case the score changed since they were indexed.
+ *
+ * \param index - the index
+ * \param n - the student to remove
+ *
+ * \return 0, or -1 if the student was not in the index
+ */
+int score_index_remove(struct score_index *index, struct node *n){
+	double score = node_score(n, index->assignment);
+	long int position = score_index_seek(index, score, 0);
+
+	while (position < index->length && index->entries[position].score == score &&
+	       index->entries[position].node != n){
+		++position;
+	}
+	if (position == index->length || index->entries[position].node != n){
+		for (position = 0; position < index->length && index->entries[position].node != n; ++position);
+		if (position == index->length) return -1;
+	}
+
+	memmove(index->entries + position, index->entries + position + 1,
+	        (index->length - position - 1) * sizeof(struct score_entry));
+	--index->length;
+
+	return 0;
+}
+
+
+/*!
+ * \brief moves a student to their place in a score index after their score has changed
+ *
+ * \param index - the index
+ * \param n - the student whose score changed
+ *
+ * \return 0, or -1 if the student was not in the index
+ */
+int score_index_update(struct score_index *index, struct node *n){
+	if (score_index_remove(index, n) != 0) return -1;
+
+	return score_index_add(index, n);
+}
+
+
+/*!
+ * \brief the student at a given rank
+ *
+ * \param index - the index
+ * \param rank - the rank, from 0
+ * \param sort_order - ASCEND to count from the lowest score, DESCEND from the highest
+ *
+ * \return the student, or NULL if the rank is out of range
+ */
+struct node *score_index_nth(struct score_index *index, long int rank, int sort_order){
+	if (rank < 0 || rank >= index->length) return NULL;
+
+	return index->entries[(sort_order == ASCEND) ? rank : index->length - 1 - rank].node;
+}
+
+
+/*!
+ * \brief inserts a student into the list as insert does, and adds them to a score index
+ *
+ * \param head - the head of the list
+ * \param index - score index over the list
+ * \param given - the given name to store in the list
+ * \param family - the family name to store in the list
+ * \param assignments - the list of assignments for the given student
+ * \param num_assignments - the length of the assignments list
+ * \param name_order - which of the 2 names to use, or SCORE
+ * \param sort_order - the direction of the sort
+ *
+ * \return pointer to the head node, or NULL if memory runs out, as for insert (the list and the
+ *         index are then left as they were, as they are for ASSIGNMENT_SCORE)
+ */
+struct node *indexed_insert(struct node *head, struct score_index *index, char *given, char *family,
+                            struct assignment *assignments, long int num_assignments, int name_order,
+                            int sort_order){
+	struct node *tmp;
+
+	if (name_order == ASSIGNMENT_SCORE) return head;
+
+	tmp = new_node(given, family, assignments, num_assignments, name_order, sort_order);
+	if (tmp == NULL) return NULL;
+
+	/* index first, as that is the step that can fail, and linking the node in can't */
+	if (score_index_add(index, tmp) != 0){
+		free_node(tmp);
+		return NULL;
+	}
+
+	return insert_node(head, tmp, name_order, sort_order);
+}
+
+
+/*!
+ * \brief removes the nth student from the list as delete_nth does, and from a score index
+ *
+ * \param head - the head of the list
+ * \param index - score index over the list
+ * \param location - the location to remove
+ *
+ * \return pointer to the head node
+ */
+struct node *indexed_delete_nth(struct node *head, struct score_index *index, int location){
+	struct node *doomed = nth_node(head_pointer(head), location);
+
+	if (doomed != NULL) score_index_remove(index, doomed);
+
+	return delete_nth(head, location);
+}
+
+
+/*!
+ * \brief inserts a student, or updates them in place if the list already has someone with both
+ * names. The lookup goes through a hash table over the list, so it takes amortized O(1) rather
+ * than a walk of the list.
+ *
+ * \param head - the head of the list
+ * \param t - student table over the list, from student_table_build, kept current here (but not by
+ *            other changes to the list; see upserted_delete_nth to remove a student)
+ * \param given - the given name of the student
+ * \param family - the family name of the student
+ * \param assignments - the student's assignments
+ * \param num_assignments - the length of the assignments list
+ * \param name_order - which of the 2 names to sort on
+ * \param sort_order - the direction of the sort
+ * \param mode - UPSERT_MERGE to add the assignments to those the student has (overwriting equal
+ *               names), UPSERT_REPLACE to replace the student's assignments outright
+ *
+ * \return pointer to the head node (the list is left as it is for ASSIGNMENT_SCORE)
+ */
+struct node *upsert(struct node *head, struct student_table *t, char *given, char *family,
+                    struct assignment *assignments, long int num_assignments, int name_order,
+                    int sort_order, int mode){
+	long int slot = student_table_slot(t, given, family);
+	struct node *found = t->slots[slot];
+	struct node *tmp;
+
+	if (name_order == ASSIGNMENT_SCORE) return head;
+
+	if (found != NULL && mode == UPSERT_MERGE){
+		merge_scores(found, assignments, num_assignments);
+		return head_pointer(found);
+	}
+
+	tmp = new_node(given, family, assignments, num_assignments, name_order, sort_order);
+	if (tmp == NULL) return head;
+
+	if (found != NULL){
+		/* same names, so the replacement takes the same place in the list */
+		t->slots[slot] = tmp;
+		return head_pointer(replace_student(found, tmp));
+	}
+
+	head = insert_node(head, tmp, name_order, sort_order);
+	student_table_add(t, tmp);
+
+	return head;
+}
+
+
+/*!
+ * \brief reads a well formatted file as list_from_file does, but students already in the list (or
+ * earlier in the file) are updated in place instead of being added again. New students are
+ * appended, and the list is sorted once at the end, so re-syncing a whole roster is a single
+ * pass plus a sort.
+ *
+ * \param head - pointer to a list (possibly NULL)
+ * \param stream - open file stream in read mode
+ * \param sort_key - whether to sort on first or last name
+ * \param sort_order - whether to sort ascending or descending
+ * \param mode - UPSERT_MERGE or UPSERT_REPLACE, as for upsert
+ *
+ * \return pointer to the head node (nothing is read for ASSIGNMENT_SCORE)
+ */
+struct node *upsert_from_file(struct node *head, FILE *stream, int sort_key, int sort_order, int mode){
+	struct student_table *t;
+	struct node *records;
+	struct node *tail;
+	struct node *next;
+	long int slot;
+	int added = 0;
+
+	if (sort_key == ASSIGNMENT_SCORE) return head;
+
+	/* the tail is found after the build, which may fold it into an earlier copy */
+	head = head_pointer(head);
+	t = student_table_build(head);
+	tail = tail_pointer(head);
+	records = list_from_file(NULL, stream, sort_key, sort_order);
+	if (t == NULL){
+		/* no table to deduplicate with */
+		delete_list(records);
+		return head;
+	}
+
+	for (struct node *cursor = records; cursor != NULL; cursor = next){
+		next = cursor->previous;
+		cursor->next = NULL;
+		cursor->previous = NULL;
+
+		slot = student_table_slot(t, cursor->first_name, cursor->last_name);
+		if (t->slots[slot] != NULL && mode == UPSERT_MERGE){
+			combine_students(t->slots[slot], cursor);
+		}else if (t->slots[slot] != NULL){
+			if (t->slots[slot] == tail) tail = cursor;
+			if (t->slots[slot] == head) head = cursor;
+			replace_student(t->slots[slot], cursor);
+			t->slots[slot] = cursor;
+		}else{
+			/* chain the new student onto the tail, it gets put in its place by the sort below */
+			cursor->next = tail;
+			if (tail != NULL){
+				tail->previous = cursor;
+			}else{
+				head = cursor;
+			}
+			tail = cursor;
+			student_table_add(t, cursor);
+			added = 1;
+		}
+	}
+
+	student_table_free(t);
+
+	return added ? bulk_sort_list(head, sort_key, sort_order) : sort_list(head, sort_key, sort_order);
+}
+
+
+/*!
+ * \brief removes the nth student from the list as delete_nth does, and from a student table
+ *
+ * \param head - the head of the list
+ * \param t - student table over the list
+ * \param location - the location to remove
+ *
+ * \return pointer to the head node
+ */
+struct node *upserted_delete_nth(struct node *head, struct student_table *t, int location){
+	struct node *doomed = nth_node(head_pointer(head), location);
+
+	if (doomed != NULL) student_table_remove(t, doomed);
+
+	return delete_nth(head, location);
+}
+
+
+/*!
+ * \brief puts a node in the place of another one in the list, and frees the old one
+ *
+ * \param old - the node to replace
+ * \param replacement - an unlinked node to take its place
+ *
+ * \return the replacement
+ */
+struct node *replace_student(struct node *old, struct node *replacement){
+	replacement->next = old->next;
+	replacement->previous = old->previous;
+	replacement->sort_key = old->sort_key;
+	replacement->sort_order = old->sort_order;
+	if (old->next != NULL) old->next->previous = replacement;
+	if (old->previous != NULL) old->previous->next = replacement;
+
+	free_node(old);
+
+	return replacement;
+}
+
+
+/*!
+ * \brief sets scores of a student, adding the assignments they don't have yet
+ *
+ * \param n - the student
+ * \param assignments - the scores to set
+ * \param num_assignments - how many there are
+ */
+void merge_scores(struct node *n, struct assignment *assignments, long int num_assignments){
+	long int index;
+
+	for (long int i = 0; i < num_assignments; ++i){
+		index = assignment_index(n, assignments[i].name);
+		if (index >= 0){
+			n->assignments[index].value = assignments[i].value;
+		}else{
+			node_add_assignment(n, assignments[i].name, assignments[i].value);
+		}
+	}
+}
+
+
+/*!
+ * \brief creates an empty student table, big enough that the expected number of students can be
+ * added without it growing
+ *
+ * \param expected - how many students it is expected to hold
+ *
+ * \return pointer to the new table, or NULL if memory runs out
+ */
+struct student_table *student_table_new(long int expected){
+	struct student_table *t = (struct student_table *)malloc(sizeof(struct student_table));
+
+	if (t == NULL) return NULL;
+
+	/* keep the table at most half full */
+	for (t->capacity = 16; t->capacity < 2 * expected; t->capacity *= 2);
+	t->count = 0;
+	t->slots = (struct node **)calloc(t->capacity, sizeof(struct node *));
+	if (t->slots == NULL){
+		free(t);
+		return NULL;
+	}
+
+	return t;
+}
+
+
+/*!
+ * \brief builds a hash table of the students of a list, keyed on both names. A student who is in
+ * the list more than once is folded into their first copy with combine_students, so the head
+ * stays where it is, but later copies are unlinked and freed.
+ *
+ * \param head - the head of the list (possibly NULL)
+ *
+ * \return pointer to the new table, or NULL if memory runs out
+ */
+struct student_table *student_table_build(struct node *head){
+	struct node *cursor = head_pointer(head);
+	struct student_table *t = student_table_new(list_length(cursor));
+	struct node *next;
+	long int slot;
+
+	if (t == NULL) return NULL;
+
+	for (; cursor != NULL; cursor = next){
+		next = cursor->previous;
+		slot = student_table_slot(t, cursor->first_name, cursor->last_name);
+		if (t->slots[slot] != NULL){
+			/* never the head, the first copy is the one kept */
+			cursor->next->previous = next;
+			if (next != NULL) next->next = cursor->next;
+			cursor->next = NULL;
+			cursor->previous = NULL;
+			combine_students(t->slots[slot], cursor);
+		}else{
+			t->slots[slot] = cursor;
+			++t->count;
+		}
+	}
+
+	return t;
+}
+
+
+/*!
+ * \brief releases a student table, but not the students in it
+ *
+ * \param t - the table to free
+ */
+void student_table_free(struct student_table *t){
+	if (t == NULL) return;
+
+	free(t->slots);
+	free(t);
+}
+
+
+/*!
+ * \brief FNV-1a hash of a pair of names
+ *
+ * \param given - the given name
+ * \param family - the family name
+ *
+ * \return the hash
+ */
+uint64_t student_hash(char *given, char *family){
+	uint64_t hash = 14695981039346656037ULL;
+
+	for (; *given != '\0'; ++given){
+		hash = (hash ^ (unsigned char)*given) * 1099511628211ULL;
+	}
+	/* a separator, so moving letters from one name to the other changes the hash */
+	hash = (hash ^ 0xFF) * 1099511628211ULL;
+	for (; *family != '\0'; ++family){
+		hash = (hash ^ (unsigned char)*family) * 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+
+/*!
+ * \brief finds the slot of a student in the table, probing linearly from their hash
+ *
+ * \param t - the table
+ * \param given - the given name
+ * \param family - the family name
+ *
+ * \return the slot holding the student, or the empty slot where they would go
+ */
+long int student_table_slot(struct student_table *t, char *given, char *family){
+	long int slot = student_hash(given, family) & (t->capacity - 1);
+	struct node *n;
+
+	while ((n = t->slots[slot]) != NULL){
+		if (strcmp(n->first_name, given) == 0 && strcmp(n->last_name, family) == 0) break;
+		slot = (slot + 1) & (t->capacity - 1);
+	}
+
+	return slot;
+}
+
+
+/*!
+ * \brief looks a student up by both names
+ *
+ * \param t - the table
+ * \param given - the given name
+ * \param family - the family name
+ *
+ * \return the student, or NULL if they are not in the table
+ */
+struct node *student_table_find(struct student_table *t, char *given, char *family){
+	return t->slots[student_table_slot(t, given, family)];
+}
+
+
+/*!
+ * \brief adds a student to the table, doubling it first if it would become more than half full
+ *
+ * \param t - the table
+ * \param n - the student; if their names are in the table already, n takes that slot over
+ *
+ * \return 0, or -1 if memory ran out
+ */
+int student_table_add(struct student_table *t, struct node *n){
+	struct node **old = t->slots;
+	long int old_capacity = t->capacity;
+	long int slot;
+
+	if (2 * (t->count + 1) > t->capacity){
+		t->slots = (struct node **)calloc(2 * old_capacity, sizeof(struct node *));
+		if (t->slots == NULL){
+			t->slots = old;
+			return -1;
+		}
+		t->capacity = 2 * old_capacity;
+		for (long int i = 0; i < old_capacity; ++i){
+			if (old[i] != NULL){
+				t->slots[student_table_slot(t, old[i]->first_name, old[i]->last_name)] = old[i];
+			}
+		}
+		free(old);
+	}
+
+	slot = student_table_slot(t, n->first_name, n->last_name);
+	if (t->slots[slot] == NULL) ++t->count;
+	t->slots[slot] = n;
+
+	return 0;
+}
+
+
+/*!
+ * \brief takes a student out of the table. The entries probed past the freed slot are shifted back
+ * into it where their probe sequence allows, so lookups never need tombstones.
+ *
+ * \param t - the table
+ * \param n - the student
+ *
+ * \return 0, or -1 if the student is not in the table
+ */
+int student_table_remove(struct student_table *t, struct node *n){
+	long int hole = student_table_slot(t, n->first_name, n->last_name);
+	long int next = hole;
+	long int home;
+	struct node *moving;
+
+	if (t->slots[hole] != n) return -1;
+
+	t->slots[hole] = NULL;
+	--t->count;
+
+	while ((moving = t->slots[next = (next + 1) & (t->capacity - 1)]) != NULL){
+		home = student_hash(moving->first_name, moving->last_name) & (t->capacity - 1);
+
+		/* it can move back unless its home lies after the hole, on the way round to it */
+		if (((next - home) & (t->capacity - 1)) >= ((next - hole) & (t->capacity - 1))){
+			t->slots[hole] = moving;
+			t->slots[next] = NULL;
+			hole = next;
+		}
+	}
+
+	return 0;
+}
+
+
+/*!
+ * \brief search the list for a student by both names, using the sort order of the list to stop
+ * as soon as the student can no longer be ahead
+ *
+ * \param head - the head of the list
+ * \param given - given name of the student
+ * \param family - family name of the student
+ *
+ * \return pointer to the node of the student, or NULL if not found
+ */
+struct node *find_student(struct node *head, char *given, char *family){
+	struct node *cursor = head_pointer(head);
+	char *names[] = {given, family};
+	uint64_t prefixes[] = {key_prefix(given), key_prefix(family)};
+	int comp;
+
+	while (cursor != NULL){
+		char *node_names[] = {cursor->first_name, cursor->last_name};
+
+		if (cursor->sort_key >= SCORE){
+			/* not in name order, so every student has to be looked at */
+			if (strcmp(given, cursor->first_name) == 0 && strcmp(family, cursor->last_name) == 0){
+				return cursor;
+			}
+			cursor = cursor->previous;
+			continue;
+		}
+
+		comp = key_compare(prefixes[cursor->sort_key], names[cursor->sort_key],
+		                   cursor->key_prefix[cursor->sort_key], node_names[cursor->sort_key]);
+		comp *= cursor->sort_order;
+		if (comp < 0){
+			/* walked past where the student would be */
+			return NULL;
+		}
+		if (comp == 0 && strcmp(names[!cursor->sort_key], node_names[!cursor->sort_key]) == 0){
+			return cursor;
+		}
+
+		cursor = cursor->previous;
+	}
+
+	return NULL;
+}
+
+
+/*!
+ * \brief change a single score in place
+ *
+ * \param head - the head of the list
+ * \param given - given name of the student
+ * \param family - family name of the student
+ * \param assignment - name of the assignment
+ * \param value - the new score
+ *
+ * \return 1 if the score was changed, 0 if the student or assignment was not found
+ */
+int set_score(struct node *head, char *given, char *family, char *assignment, double value){
+	struct node *student = find_student(head, given, family);
+	long int i;
+
+	if (student == NULL) return 0;
+
+	i = assignment_index(student, assignment);
+	if (i < 0) return 0;
+
+	student->assignments[i].value = value;
+
+	return 1;
+}
+
+
+/*!
+ * \brief add an assignment column to every student that does not already have it
+ *
+ * \param head - the head of the list
+ * \param assignment - name of the new assignment
+ * \param value - the score to start everyone on
+ *
+ * \return number of students the column was added to
+ */
+long int add_assignment(struct node *head, char *assignment, double value){
+	struct node *cursor = head_pointer(head);
+	long int added = 0;
+
+	for (; cursor != NULL; cursor = cursor->previous){
+		if (assignment_index(cursor, assignment) >= 0) continue;
+		if (node_add_assignment(cursor, assignment, value) != 0) break;
+
+		++added;
+	}
+
+	return added;
+}
+
+
+/*!
+ * \brief appends an assignment to one node, without checking whether it has it already
+ *
+ * \param n - the node to add to
+ * \param assignment - name of the assignment
+ * \param value - score for the assignment
+ *
+ * \return 0 on success, -1 if memory ran out
+ */
+int node_add_assignment(struct node *n, char *assignment, double value){
+	struct assignment *grown;
+	int assignment_name_length = min(strlen(assignment) + 1, MAX_STRING_LENGTH);
+
+	if (n->num_assignments < n->assignment_capacity){
+		/* a dropped assignment left room */
+		grown = n->assignments;
+	}else if (node_assignments_inline(n)){
+		/* the array can't grow inside the node, so it moves to its own allocation */
+		grown = (struct assignment *)malloc((n->num_assignments + 1) * sizeof(struct assignment));
+		if (grown != NULL){
+			memcpy(grown, n->assignments, n->num_assignments * sizeof(struct assignment));
+		}
+	}else{
+		grown = (struct assignment *)realloc(n->assignments, (n->num_assignments + 1) * sizeof(struct assignment));
+	}
+	if (grown == NULL) return -1;
+
+	if (grown != n->assignments){
+		n->assignments = grown;
+		n->assignment_capacity = n->num_assignments + 1;
+	}
+	grown[n->num_assignments].name = (char *)malloc(assignment_name_length);
+	if (grown[n->num_assignments].name == NULL) return -1;
+	strncpy(grown[n->num_assignments].name, assignment, assignment_name_length);
+	grown[n->num_assignments].name[assignment_name_length - 1] = '\0';
+	grown[n->num_assignments].value = value;
+	n->num_assignments++;
+
+	return 0;
+}
+
+
+/*!
+ * \brief remove an assignment column from every student that has it
+ *
+ * \param head - the head of the list
+ * \param assignment - name of the assignment to remove
+ *
+ * \return number of students the column was removed from
+ */
+long int drop_assignment(struct node *head, char *assignment){
+	struct node *cursor = head_pointer(head);
+	long int dropped = 0;
+	long int i;
+
+	for (; cursor != NULL; cursor = cursor->previous){
+		i = assignment_index(cursor, assignment);
+		if (i < 0) continue;
+
+		/* close the gap, the array keeps its old capacity */
+		free(cursor->assignments[i].name);
+		memmove(cursor->assignments + i, cursor->assignments + i + 1,
+		        (cursor->num_assignments - i - 1) * sizeof(struct assignment));
+		cursor->num_assignments--;
+
+		++dropped;
+	}
+
+	return dropped;
+}
+
+
+/*!
+ * \brief reads a delta file, made of lines of the form given,family,assignment,score, and applies
+ * every change to the list. The deltas are sorted the same way as the list, and then the two are
+ * walked together once, so a batch of D changes to N students costs O(N + D log D): one walk of
+ * the list (as far as the last student changed) and a sort, rather than a list scan per change.
+ * Changes to the same score are applied in file order. The whole file is read before anything is
+ * changed, so a bad line leaves the list untouched.
+ *
+ * \param head - the head of the list
+ * \param stream - open file stream in read mode
+ * \param error_line - output parameter, on error set to the number (from 1) of the first malformed
+ *                     line, or to 0 if memory ran out
+ *
+ * \return number of changes applied (changes to unknown students or assignments are skipped), or
+ *         -1 on error
+ */
+long int apply_delta_file(struct node *head, FILE *stream, long int *error_line){
+	struct node *cursor = head_pointer(head);
+	struct delta *deltas = NULL;
+	struct delta *grown;
+	long int capacity = 0;
+	long int length = 0;
+	long int applied = 0;
+	long int line_number = 0;
+	long int d = 0;
+	long int i;
+	int sort_key;
+	int consumed;
+	int failed = 0;
+	char delta_format[MAX_STRING_LENGTH];
+	char *line = NULL;
+	size_t line_capacity = 0;
+
+	*error_line = 0;
+
+	if (cursor == NULL) return 0;
+
+	/* a list sorted on a score has its deltas sorted on family name, and looked up per student */
+	sort_key = (cursor->sort_key >= SCORE) ? FAMILY : cursor->sort_key;
+
+	/* generalize the formatting string, leaving room for the terminator, and noting where the
+	 * match ended so trailing junk can be caught */
+	snprintf(delta_format, MAX_STRING_LENGTH, " %%%d[^\',\'],%%%d[^\',\'],%%%d[^\',\'],%%lf %%n",
+	         MAX_STRING_LENGTH - 1, MAX_STRING_LENGTH - 1, MAX_STRING_LENGTH - 1);
+
+	/* read every change first, a line at a time */
+	while (getline(&line, &line_capacity, stream) != -1){
+		++line_number;
+		if (line[strspn(line, " \t\r\n")] == '\0') continue;
+
+		if (length == capacity){
+			capacity = (capacity == 0) ? 1024 : capacity * 2;
+			grown = (struct delta *)realloc(deltas, capacity * sizeof(struct delta));
+			if (grown == NULL){
+				failed = 1;
+				break;
+			}
+			deltas = grown;
+		}
+
+		consumed = 0;
+		if (sscanf(line, delta_format, deltas[length].names[GIVEN], deltas[length].names[FAMILY],
+		           deltas[length].assignment, &deltas[length].value, &consumed) != 4 ||
+		    line[consumed] != '\0'){
+			*error_line = line_number;
+			failed = 1;
+			break;
+		}
+
+		deltas[length].sort_key = sort_key;
+		deltas[length].line = length;
+		++length;
+	}
+
+	/* a bad line, or stopping short of the end of the file, fails the whole batch */
+	if (failed || !feof(stream) || ferror(stream)){
+		free(line);
+		free(deltas);
+		return -1;
+	}
+	free(line);
+
+	qsort(deltas, length, sizeof(struct delta), delta_compare);
+
+	/* the deltas are ascending, so walk the list in ascending order too */
+	if (cursor->sort_order == DESCEND){
+		cursor = tail_pointer(cursor);
+	}
+
+	for (; cursor != NULL; cursor = (cursor->sort_order == ASCEND) ? cursor->previous : cursor->next){
+		char *node_names[] = {cursor->first_name, cursor->last_name};
+
+		if (cursor->sort_key >= SCORE){
+			/* out of name order, so every student is looked up, and none can end the walk */
+			d = delta_seek(deltas, length, node_names[sort_key]);
+		}else if (d == length){
+			/* no changes left for the students still to come */
+			break;
+		}
+
+		/* skip changes for students that would have come before this one */
+		while (d < length && strcmp(deltas[d].names[sort_key], node_names[sort_key]) < 0){
+			++d;
+		}
+
+		/* apply the run of changes that share this sort name (several students may share it) */
+		for (long int e = d; e < length && strcmp(deltas[e].names[sort_key], node_names[sort_key]) == 0; ++e){
+			if (strcmp(deltas[e].names[!sort_key], node_names[!sort_key]) != 0) continue;
+
+			i = assignment_index(cursor, deltas[e].assignment);
+			if (i >= 0){
+				cursor->assignments[i].value = deltas[e].value;
+				++applied;
+			}
+		}
+	}
+
+	free(deltas);
+
+	return applied;
+}
+
+
+/*!
+ * \brief find an assignment of a student by name
+ *
+ * \param n - the student
+ * \param assignment - name of the assignment
+ *
+ * \return index into the assignments array, or -1 if not found
+ */
+long int assignment_index(struct node *n, char *assignment){
+	if (n == NULL || n->assignments == NULL) return -1;
+
+	for (long int i = 0; i < n->num_assignments; ++i){
+		if (strcmp(n->assignments[i].name, assignment) == 0){
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+
+/*!
+ * \brief compare function used by qsort on deltas: ascending on the sort name, then the other
+ * name, then file order
+ *
+ * \param s - struct delta, passed as void*
+ * \param t - struct delta, passed as void*
+ *
+ * \return an integer less than, equal to, or greater than zero, as strcmp
+ */
+int delta_compare(const void *s, const void *t){
+	struct delta *is = (struct delta *)s;
+	struct delta *it = (struct delta *)t;
+	int comp = strcmp(is->names[is->sort_key], it->names[it->sort_key]);
+
+	if (comp == 0){
+		comp = strcmp(is->names[!is->sort_key], it->names[!it->sort_key]);
+	}
+	if (comp == 0){
+		comp = (is->line > it->line) - (is->line < it->line);
+	}
+
+	return comp;
+}
+
+
+/*!
+ * \brief binary search of sorted deltas for the first one with the given sort name
+ *
+ * \param deltas - the deltas, sorted with delta_compare
+ * \param length - how many there are
+ * \param name - the sort name to look for
+ *
+ * \return index of the first delta not before the name, from 0 to length
+ */
+long int delta_seek(struct delta *deltas, long int length, char *name){
+	long int low = 0;
+	long int high = length;
+	long int middle;
+
+	while (low < high){
+		middle = low + (high - low) / 2;
+		if (strcmp(deltas[middle].names[deltas[middle].sort_key], name) < 0){
+			low = middle + 1;
+		}else{
+			high = middle;
+		}
+	}
+
+	return low;
+}
+
+
+/*!
+ * \brief copies the whole list into a new persistent version. Later versions derived from this
+ * one (via version_snapshot) share all of its storage until they are written to.
+ *
+ * \param head - the head of the list (possibly NULL)
+ *
+ * \return pointer to the new version, or NULL on allocation failure
+ */
+struct version *version_from_list(struct node *head){
+	struct node *cursor = head_pointer(head);
+	long int length = list_length(head);
+	struct version_record **records = NULL;
+	struct version *v = (struct version *)malloc(sizeof(struct version));
+
+	if (v == NULL) return v;
+
+	v->root = NULL;
+	v->length = length;
+
+	if (length > 0){
+		records = (struct version_record **)malloc(length * sizeof(struct version_record *));
+		if (records == NULL){
+			free(v);
+			return NULL;
+		}
+
+		/* detach a private copy of each student from the list */
+		for (long int i = 0; i < length && cursor != NULL; ++i, cursor = cursor->previous){
+			struct node *student = new_node(cursor->first_name, cursor->last_name, cursor->assignments,
+			                                cursor->num_assignments, FAMILY, ASCEND);
+
+			records[i] = (student == NULL) ? NULL : version_record_new(student);
+			if (records[i] == NULL){
+				free_node(student);
+				version_records_free(records, i);
+				free(records);
+				free(v);
+				return NULL;
+			}
+		}
+
+		/* the list may be in any order, the tree is always family then given name */
+		qsort(records, length, sizeof(struct version_record *), version_record_compare);
+		v->root = version_build(records, length);
+		if (v->root == NULL){
+			version_records_free(records, length);
+			free(v);
+			v = NULL;
+		}
+
+		free(records);
+	}
+
+	return v;
+}
+
+
+/*!
+ * \brief takes a snapshot of a version in constant time. The two versions share everything, and
+ * each copies only the path it writes to from then on.
+ *
+ * \param v - the version to snapshot
+ *
+ * \return pointer to the new version, or NULL if v is NULL or on allocation failure
+ */
+struct version *version_snapshot(struct version *v){
+	struct version *snapshot;
+
+	if (v == NULL) return NULL;
+
+	snapshot = (struct version *)malloc(sizeof(struct version));
+	if (snapshot != NULL){
+		snapshot->root = v->root;
+		snapshot->length = v->length;
+
+		/* the snapshot is one more owner of the root */
+		if (snapshot->root != NULL){
+			snapshot->root->references++;
+		}
+	}
+
+	return snapshot;
+}
+
+
+/*!
+ * \brief adds a student to the given version, copying only the nodes along the insertion path
+ *
+ * \param v - the version to add to
+ * \param given - the given name of the student
+ * \param family - the family name of the student
+ * \param assignments - the list of assignments for the given student
+ * \param num_assignments - the length of the assignments list
+ *
+ * \return pointer to the version, or NULL if memory ran out (the version then still holds what it
+ *         did before, though some of its nodes may no longer be shared)
+ */
+struct version *version_insert(struct version *v, char *given, char *family,
+                               struct assignment *assignments, long int num_assignments){
+	struct version_record *record;
+	struct node *student;
+	int failed = 0;
+
+	if (v == NULL) return v;
+
+	student = new_node(given, family, assignments, num_assignments, FAMILY, ASCEND);
+	record = (student == NULL) ? NULL : version_record_new(student);
+	if (record == NULL){
+		free_node(student);
+		return NULL;
+	}
+
+	v->root = version_insert_node(v->root, record, &failed);
+	if (failed){
+		free_node(student);
+		free(record);
+		return NULL;
+	}
+	v->length++;
+
+	return v;
+}
+
+
+/*!
+ * \brief changes one score of one student in the given version. Any other version sharing the
+ * student is left untouched, as the path to the student (and the student) are copied on write.
+ *
+ * \param v - the version to change
+ * \param given - the given name of the student
+ * \param family - the family name of the student
+ * \param assignment - the name of the assignment to change
+ * \param value - the new score
+ *
+ * \return 1 if the score was changed, 0 if no such student or assignment exists, or memory ran out
+ */
+int version_set_score(struct version *v, char *given, char *family, char *assignment, double value){
+	struct node *student = version_find(v, given, family);
+	struct version_node **link;
+	struct version_node *edited;
+	struct version_record *record;
+	long int i;
+	int comp;
+
+	if (student == NULL) return 0;
+
+	/* make sure the assignment exists before copying anything */
+	for (i = 0; i < student->num_assignments; ++i){
+		if (strcmp(student->assignments[i].name, assignment) == 0) break;
+	}
+	if (i == student->num_assignments) return 0;
+
+	/* walk down again, taking private copies of every shared node on the way (a copy that is
+	 * already made stays valid if memory runs out further down, it is just no longer shared) */
+	link = &v->root;
+	while (1){
+		edited = version_edit(*link);
+		if (edited == NULL) return 0;
+		*link = edited;
+		comp = version_compare(given, family, (*link)->record->student);
+
+		if (comp == 0) break;
+
+		link = (comp < 0) ? &(*link)->left : &(*link)->right;
+	}
+
+	record = version_record_edit((*link)->record);
+	if (record == NULL) return 0;
+	(*link)->record = record;
+	(*link)->record->student->assignments[i].value = value;
+
+	return 1;
+}
+
+
+/*!
+ * \brief searches a version for a student. The returned record may be shared with other versions
+ * and must be treated as read only.
+ *
+ * \param v - the version to search
+ * \param given - the given name of the student
+ * \param family - the family name of the student
+ *
+ * \return pointer to the student record, or NULL if not found
+ */
+struct node *version_find(struct version *v, char *given, char *family){
+	struct version_node *cursor = (v == NULL) ? NULL : v->root;
+	int comp;
+
+	while (cursor != NULL){
+		comp = version_compare(given, family, cursor->record->student);
+
+		if (comp == 0){
+			return cursor->record->student;
+		}
+
+		cursor = (comp < 0) ? cursor->left : cursor->right;
+	}
+
+	return NULL;
+}
+
+
+/*!
+ * \brief builds an ordinary list out of a version, with the requested sort order
+ *
+ * \param v - the version to copy out
+ * \param sort_key - whether to sort on first or last name
+ * \param sort_order - whether to sort ascending or descending
+ *
+ * \return pointer to the head node, or NULL if the version is empty, memory runs out, or sort_key
+ *         is ASSIGNMENT_SCORE
+ */
+struct node *list_from_version(struct version *v, int sort_key, int sort_order){
+	struct node *tail;
+	int failed = 0;
+
+	if (v == NULL || v->root == NULL || sort_key == ASSIGNMENT_SCORE) return NULL;
+
+	/* the tree already holds a family, ascending ordering, so chain it up in order */
+	tail = version_append(v->root, NULL, &failed);
+	if (failed){
+		delete_list(tail);
+		return NULL;
+	}
+
+	return sort_list(head_pointer(tail), sort_key, sort_order);
+}
+
+
+/*!
+ * \brief releases a version. Storage shared with other versions is kept until its last owner goes.
+ *
+ * \param v - the version to free
+ */
+void version_free(struct version *v){
+	if (v == NULL) return;
+
+	version_release(v->root);
+	free(v);
+}
+
+
+/*!
+ * \brief the ordering used by the version tree: family name, then given name
+ *
+ * \param given - given name to look for
+ * \param family - family name to look for
+ * \param student - the record to compare against
+ *
+ * \return an integer less than, equal to, or greater than zero, as strcmp
+ */
+int version_compare(char *given, char *family, struct node *student){
+	int comp = strcmp(family, student->last_name);
+
+	if (comp == 0){
+		comp = strcmp(given, student->first_name);
+	}
+
+	return comp;
+}
+
+
+/*!
+ * \brief compare function used by qsort on arrays of version records
+ *
+ * \param s - struct version_record *, passed as void*
+ * \param t - struct version_record *, passed as void*
+ *
+ * \return an integer less than, equal to, or greater than zero, as version_compare
+ */
+int version_record_compare(const void *s, const void *t){
+	struct node *is = (*(struct version_record **)s)->student;
+	struct node *it = (*(struct version_record **)t)->student;
+
+	return version_compare(is->first_name, is->last_name, it);
+}
+
+
+/*!
+ * \brief height of a subtree, treating an empty tree as 0
+ *
+ * \param n - root of the subtree
+ *
+ * \return height of the subtree
+ */
+int version_height(struct version_node *n){
+	return (n == NULL) ? 0 : n->height;
+}
+
+
+/*!
+ * \brief wraps a detached student in a new record, owned once
+ *
+ * \param student - the student record
+ *
+ * \return pointer to the new record
+ */
+struct version_record *version_record_new(struct node *student){
+	struct version_record *r = (struct version_record *)malloc(sizeof(struct version_record));
+
+	if (r != NULL){
+		r->student = student;
+		r->references = 1;
+	}
+
+	return r;
+}
+
+
+/*!
+ * \brief builds a perfectly balanced tree out of a sorted array of records
+ *
+ * \param records - sorted array of records
+ * \param length - how many records there are
+ *
+ * \return root of the new tree, or NULL if memory runs out (the records are left alone)
+ */
+struct version_node *version_build(struct version_record **records, long int length){
+	struct version_node *n;
+	long int middle = length / 2;
+
+	if (length <= 0) return NULL;
+
+	n = (struct version_node *)malloc(sizeof(struct version_node));
+	if (n == NULL) return NULL;
+
+	n->record = records[middle];
+	n->references = 1;
+	n->left = version_build(records, middle);
+	n->right = version_build(records + middle + 1, length - middle - 1);
+	if ((middle > 0 && n->left == NULL) || (length - middle - 1 > 0 && n->right == NULL)){
+		version_discard(n);
+		return NULL;
+	}
+	n->height = 1 + max(version_height(n->left), version_height(n->right));
+
+	return n;
+}
+
+
+/*!
+ * \brief frees the nodes of a tree that is being built, and so is not shared, leaving the records
+ *
+ * \param n - root of the tree
+ */
+void version_discard(struct version_node *n){
+	if (n == NULL) return;
+
+	version_discard(n->left);
+	version_discard(n->right);
+	free(n);
+}
+
+
+/*!
+ * \brief frees an array of records not yet in any tree, along with their students
+ *
+ * \param records - the records
+ * \param length - how many there are
+ */
+void version_records_free(struct version_record **records, long int length){
+	for (long int i = 0; i < length; ++i){
+		free_node(records[i]->student);
+		free(records[i]);
+	}
+}
+
+
+/*!
+ * \brief copy on write for tree nodes. A node owned only by the caller is returned as is, a shared
+ * node is copied, with the copy taking a reference to both children and the record.
+ *
+ * \param n - the node about to be written to
+ *
+ * \return a node the caller owns exclusively, or NULL if memory runs out (n is left as it was)
+ */
+struct version_node *version_edit(struct version_node *n){
+	struct version_node *copy;
+
+	if (n == NULL || n->references == 1) return n;
+
+	copy = (struct version_node *)malloc(sizeof(struct version_node));
+	if (copy == NULL) return NULL;
+	*copy = *n;
+	copy->references = 1;
+
+	/* the copy is another owner of everything below it */
+	if (copy->left != NULL) copy->left->references++;
+	if (copy->right != NULL) copy->right->references++;
+	copy->record->references++;
+
+	/* and the caller no longer points at the original */
+	n->references--;
+
+	return copy;
+}
+
+
+/*!
+ * \brief copy on write for student records, as version_edit
+ *
+ * \param r - the record about to be written to
+ *
+ * \return a record the caller owns exclusively, or NULL if memory runs out (r is left as it was)
+ */
+struct version_record *version_record_edit(struct version_record *r){
+	struct version_record *copy;
+	struct node *student;
+
+	if (r->references == 1) return r;
+
+	student = new_node(r->student->first_name, r->student->last_name, r->student->assignments,
+	                   r->student->num_assignments, FAMILY, ASCEND);
+	copy = (student == NULL) ? NULL : version_record_new(student);
+	if (copy == NULL){
+		free_node(student);
+		return NULL;
+	}
+
+	r->references--;
+
+	return copy;
+}
+
+
+/*!
+ * \brief rotates a subtree to restore balance. Both nodes involved must be owned by the caller.
+ *
+ * \param n - root of the subtree
+ * \param direction - ASCEND to rotate left (right child rises) \n
+ *                    DESCEND to rotate right (left child rises)
+ *
+ * \return the new root of the subtree
+ */
+struct version_node *version_rotate(struct version_node *n, int direction){
+	struct version_node *pivot;
+
+	if (direction == ASCEND){
+		pivot = n->right;
+		n->right = pivot->left;
+		pivot->left = n;
+	}else{
+		pivot = n->left;
+		n->left = pivot->right;
+		pivot->right = n;
+	}
+
+	n->height = 1 + max(version_height(n->left), version_height(n->right));
+	pivot->height = 1 + max(version_height(pivot->left), version_height(pivot->right));
+
+	return pivot;
+}
+
+
+/*!
+ * \brief restores the AVL balance of a subtree after an insertion below it
+ *
+ * \param n - root of the subtree, owned by the caller
+ *
+ * \return the new root of the subtree
+ */
+struct version_node *version_balance(struct version_node *n){
+	int balance = version_height(n->left) - version_height(n->right);
+
+	n->height = 1 + max(version_height(n->left), version_height(n->right));
+
+	if (balance > 1){
+		/* left heavy, the inner grandchild was on the insertion path so it is owned too */
+		if (version_height(n->left->left) < version_height(n->left->right)){
+			n->left = version_rotate(n->left, ASCEND);
+		}
+		n = version_rotate(n, DESCEND);
+	}else if (balance < -1){
+		if (version_height(n->right->right) < version_height(n->right->left)){
+			n->right = version_rotate(n->right, DESCEND);
+		}
+		n = version_rotate(n, ASCEND);
+	}
+
+	return n;
+}
+
+
+/*!
+ * \brief inserts a record into a subtree, copying each shared node along the way. If memory runs
+ * out the record is not inserted, and the subtree returned holds what it did before.
+ *
+ * \param n - root of the subtree (possibly NULL)
+ * \param record - the record to insert
+ * \param failed - output parameter, set to 1 if memory ran out
+ *
+ * \return the new root of the subtree
+ */
+struct version_node *version_insert_node(struct version_node *n, struct version_record *record, int *failed){
+	struct node *student = record->student;
+	struct version_node *edited;
+
+	if (n == NULL){
+		n = (struct version_node *)malloc(sizeof(struct version_node));
+		if (n == NULL){
+			*failed = 1;
+			return NULL;
+		}
+		n->left = NULL;
+		n->right = NULL;
+		n->record = record;
+		n->height = 1;
+		n->references = 1;
+		return n;
+	}
+
+	edited = version_edit(n);
+	if (edited == NULL){
+		*failed = 1;
+		return n;
+	}
+	n = edited;
+
+	if (version_compare(student->first_name, student->last_name, n->record->student) < 0){
+		n->left = version_insert_node(n->left, record, failed);
+	}else{
+		n->right = version_insert_node(n->right, record, failed);
+	}
+
+	return *failed ? n : version_balance(n);
+}
+
+
+/*!
+ * \brief copies a subtree, in order, onto the tail of a list
+ *
+ * \param n - root of the subtree
+ * \param tail - the current tail of the list (possibly NULL)
+ * \param failed - output parameter, set to 1 if memory ran out (the copying then stops)
+ *
+ * \return the new tail of the list
+ */
+struct node *version_append(struct version_node *n, struct node *tail, int *failed){
+	struct node *tmp;
+	struct node *student;
+
+	if (n == NULL) return tail;
+
+	tail = version_append(n->left, tail, failed);
+	if (*failed) return tail;
+
+	student = n->record->student;
+	tmp = new_node(student->first_name, student->last_name, student->assignments,
+	               student->num_assignments, FAMILY, ASCEND);
+	if (tmp == NULL){
+		*failed = 1;
+		return tail;
+	}
+
+	/* the list runs from head to tail along the previous pointers */
+	tmp->next = tail;
+	if (tail != NULL){
+		tail->previous = tmp;
+	}
+
+	return version_append(n->right, tmp, failed);
+}
+
+
+/*!
+ * \brief drops one reference to a subtree, freeing whatever is no longer owned by anyone
+ *
+ * \param n - root of the subtree
+ */
+void version_release(struct version_node *n){
+	if (n == NULL || --n->references > 0) return;
+
+	version_release(n->left);
+	version_release(n->right);
+
+	if (--n->record->references == 0){
+		free_node(n->record->student);
+		free(n->record);
+	}
+
+	free(n);
+}
+#endif